@@ -0,0 +1,396 @@
+#include "arrayloop.h"
+#include "functions.h"
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace {
+
+bool isNumericElement(const ASTNode& node) {
+    // A NODE_ARRAY_ACCESS with a slot of its own is an FN call
+    return node.type == NODE_ARRAY_ACCESS && node.slot < 0 && node.children.size() == 2 &&
+           node.children[0]->slot >= 0 && !VariableManager::isStringSlot(node.children[0]->slot);
+}
+
+bool isIntegerLiteral(const ASTNode& node, int& value) {
+    if (node.type != NODE_NUMBER || node.text.isString()) {
+        return false;
+    }
+    double number = node.text.number();
+    if (!(number >= -(INT_MAX / 2) && number <= INT_MAX / 2) || number != static_cast<int>(number)) {
+        return false;
+    }
+    value = static_cast<int>(number);
+    return true;
+}
+
+// The constant c of a subscript that is the counter plus c: I, I + c, c + I or I - c
+bool counterOffset(const ASTNode& subscript, int counter, int& offset) {
+    auto isCounter = [counter](const ASTNode& node) {
+        return node.type == NODE_VARIABLE && node.slot == counter;
+    };
+    if (isCounter(subscript)) {
+        offset = 0;
+        return true;
+    }
+    if (subscript.type != NODE_BINARY_OP || subscript.children.size() != 2) {
+        return false;
+    }
+    const ASTNode& left = *subscript.children[0];
+    const ASTNode& right = *subscript.children[1];
+    if (subscript.operator_type == OP_PLUS) {
+        return (isCounter(left) && isIntegerLiteral(right, offset)) ||
+               (isCounter(right) && isIntegerLiteral(left, offset));
+    }
+    if (subscript.operator_type == OP_MINUS && isCounter(left) && isIntegerLiteral(right, offset)) {
+        offset = -offset;
+        return true;
+    }
+    return false;
+}
+
+// Whether an expression has the same value on every iteration: it reads
+// neither the counter nor an array the body assigns, and has no side effects
+bool isInvariant(const ASTNode& node, int counter, const std::map<int, int>& writes) {
+    size_t first = 0;
+    switch (node.type) {
+        case NODE_VARIABLE:
+            return node.slot != counter;
+
+        case NODE_ARRAY_ACCESS:
+            if (node.slot >= 0 || node.children.empty() || writes.count(node.children[0]->slot) != 0) {
+                return false;
+            }
+            first = 1;
+            break;
+
+        case NODE_FUNCTION_CALL:
+            if (node.value == "RND" || node.value == "FRE" || node.value == "TAB" || node.value == "USR") {
+                return false;
+            }
+            break;
+
+        case NODE_PARAMETER:
+            return false;
+
+        default:
+            break;
+    }
+    for (size_t i = first; i < node.children.size(); i++) {
+        if (!isInvariant(*node.children[i], counter, writes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double (*functionFor(const std::string& name))(double) {
+    if (name == "ABS") return MathFunctions::abs;
+    if (name == "INT") return MathFunctions::int_func;
+    if (name == "SGN") return MathFunctions::sgn;
+    if (name == "SQR") return MathFunctions::sqr;
+    if (name == "SIN") return MathFunctions::sin_func;
+    if (name == "COS") return MathFunctions::cos_func;
+    if (name == "ATN") return MathFunctions::atn;
+    if (name == "EXP") return MathFunctions::exp_func;
+    if (name == "LOG") return MathFunctions::log_func;
+    return nullptr;
+}
+
+// Turns a body expression into postfix ops, or returns false if it has a part
+// the kernel doesn't run the same way the evaluator does
+struct Compiler {
+    ArrayLoop& loop;
+    const std::map<int, int>& writes;
+    size_t height = 0;
+
+    void push(const KernelOp& op, int change) {
+        loop.ops.push_back(op);
+        height += change;
+        loop.depth = std::max(loop.depth, height);
+    }
+
+    bool compile(const std::shared_ptr<ASTNode>& node) {
+        KernelOp op;
+        if (node->hoistSlot >= 0 || isInvariant(*node, loop.counter, writes)) {
+            if (node->type == NODE_NUMBER) {
+                if (node->text.isString()) {
+                    return false; // Raises its error when evaluated
+                }
+                op.kind = KernelOp::CONSTANT;
+                op.constant = node->text.number();
+            } else {
+                op.kind = KernelOp::INVARIANT;
+                op.expr = node;
+            }
+            push(op, 1);
+            return true;
+        }
+
+        switch (node->type) {
+            case NODE_VARIABLE:
+                op.kind = KernelOp::COUNTER;
+                push(op, 1);
+                return true;
+
+            case NODE_ARRAY_ACCESS: {
+                if (!isNumericElement(*node) || !counterOffset(*node->children[1], loop.counter, op.offset)) {
+                    return false;
+                }
+                // An array the body assigns is only read where this iteration assigns it
+                auto write = writes.find(node->children[0]->slot);
+                if (write != writes.end() && write->second != op.offset) {
+                    return false;
+                }
+                op.kind = KernelOp::ELEMENT;
+                op.slot = node->children[0]->slot;
+                push(op, 1);
+                return true;
+            }
+
+            case NODE_UNARY_OP:
+                if (node->children.size() != 1 || isStringOperand(*node->children[0]) ||
+                    !compile(node->children[0])) {
+                    return false;
+                }
+                if (node->operator_type == OP_MINUS) {
+                    op.kind = KernelOp::NEGATE;
+                } else if (node->value == "NOT") {
+                    op.kind = KernelOp::NOT;
+                } else {
+                    return false;
+                }
+                push(op, 0);
+                return true;
+
+            case NODE_BINARY_OP:
+                if (node->operator_type == OP_ASSIGN || node->children.size() != 2 ||
+                    isStringOperand(*node->children[0]) || isStringOperand(*node->children[1]) ||
+                    !compile(node->children[0]) || !compile(node->children[1])) {
+                    return false;
+                }
+                op.kind = KernelOp::BINARY;
+                op.op = node->operator_type;
+                push(op, -1);
+                return true;
+
+            case NODE_FUNCTION_CALL:
+                op.function = functionFor(node->value);
+                if (!op.function || node->children.size() != 1 || isStringOperand(*node->children[0]) ||
+                    !compile(node->children[0])) {
+                    return false;
+                }
+                op.kind = KernelOp::FUNCTION;
+                push(op, 0);
+                return true;
+
+            default:
+                return false;
+        }
+    }
+};
+
+// The target of LET A(subscript) = expr, or null for any other statement
+const ASTNode* arrayTarget(const ASTNode& stmt) {
+    if (stmt.type != NODE_STATEMENT || stmt.keyword != KW_LET || stmt.children.size() != 1) {
+        return nullptr;
+    }
+    const ASTNode& assignment = *stmt.children[0];
+    if (assignment.type != NODE_BINARY_OP || assignment.operator_type != OP_ASSIGN ||
+        assignment.children.size() != 2 || !isNumericElement(*assignment.children[0])) {
+        return nullptr;
+    }
+    return assignment.children[0].get();
+}
+
+std::shared_ptr<ArrayLoop> compileLoop(const ASTNode& forStatement, const std::vector<ASTNode*>& body) {
+    auto loop = std::make_shared<ArrayLoop>();
+    loop->counter = forStatement.children[0]->slot;
+
+    std::map<int, int> writes;
+    for (const ASTNode* stmt : body) {
+        const ASTNode& target = *arrayTarget(*stmt);
+        int offset;
+        if (!counterOffset(*target.children[1], loop->counter, offset)) {
+            return nullptr;
+        }
+        auto write = writes.emplace(target.children[0]->slot, offset);
+        if (write.first->second != offset) {
+            return nullptr;
+        }
+        loop->statements.push_back(KernelStatement{target.children[0]->slot, offset, 0, 0});
+    }
+
+    Compiler compiler{*loop, writes};
+    for (size_t i = 0; i < body.size(); i++) {
+        KernelStatement& statement = loop->statements[i];
+        statement.begin = loop->ops.size();
+        compiler.height = 0;
+        if (!compiler.compile(body[i]->children[0]->children[1])) {
+            return nullptr;
+        }
+        statement.end = loop->ops.size();
+    }
+    return loop;
+}
+
+// x = x op y elementwise. The common operators are plain loops the compiler
+// vectorizes; the rest go through MathFunctions::operate like the evaluator.
+bool combine(OperatorType op, double* x, const double* y, int count) {
+    switch (op) {
+        case OP_PLUS:
+            for (int k = 0; k < count; k++) x[k] += y[k];
+            return true;
+        case OP_MINUS:
+            for (int k = 0; k < count; k++) x[k] -= y[k];
+            return true;
+        case OP_MULTIPLY:
+            for (int k = 0; k < count; k++) x[k] *= y[k];
+            return true;
+        case OP_DIVIDE:
+            if (std::find(y, y + count, 0.0) != y + count) {
+                return false; // DIVISION BY ZERO
+            }
+            for (int k = 0; k < count; k++) x[k] /= y[k];
+            return true;
+        case OP_DIVIDE_NONZERO:
+            for (int k = 0; k < count; k++) x[k] /= y[k];
+            return true;
+        case OP_SQUARE:
+            for (int k = 0; k < count; k++) x[k] *= x[k];
+            return true;
+        default:
+            try {
+                for (int k = 0; k < count; k++) x[k] = MathFunctions::operate(op, x[k], y[k]);
+            } catch (const std::exception&) {
+                return false;
+            }
+            return true;
+    }
+}
+
+// Rounds computed values the way the interpreter does; false on OVERFLOW
+bool narrowAll(double* x, int count, double (*narrow)(double)) {
+    if (!narrow) {
+        return true;
+    }
+    try {
+        for (int k = 0; k < count; k++) x[k] = narrow(x[k]);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool ArrayLoop::evaluate(const KernelStatement& statement, const std::vector<double>& values,
+                         const std::vector<const Value*>& arrays, int64_t first, int64_t step, int count,
+                         double (*narrow)(double), double* result, std::vector<double>& scratch) const {
+    scratch.resize(depth * CHUNK);
+    size_t top = 0;
+    auto operand = [&scratch](size_t index) { return &scratch[index * CHUNK]; };
+
+    for (size_t i = statement.begin; i < statement.end; i++) {
+        const KernelOp& op = ops[i];
+        switch (op.kind) {
+            case KernelOp::CONSTANT:
+            case KernelOp::INVARIANT:
+                std::fill(operand(top), operand(top) + count, values[i]);
+                top++;
+                break;
+
+            case KernelOp::COUNTER: {
+                double* x = operand(top++);
+                for (int k = 0; k < count; k++) x[k] = static_cast<double>(first + k * step);
+                break;
+            }
+
+            case KernelOp::ELEMENT: {
+                double* x = operand(top++);
+                const Value* element = arrays[i] + (first + op.offset);
+                if (step == 1) {
+                    for (int k = 0; k < count; k++) x[k] = element[k].number();
+                } else {
+                    for (int k = 0; k < count; k++) x[k] = element[k * step].number();
+                }
+                break;
+            }
+
+            case KernelOp::NEGATE: {
+                double* x = operand(top - 1);
+                for (int k = 0; k < count; k++) x[k] = -x[k];
+                break;
+            }
+
+            case KernelOp::NOT: {
+                double* x = operand(top - 1);
+                for (int k = 0; k < count; k++) x[k] = x[k] == 0.0 ? -1.0 : 0.0;
+                break;
+            }
+
+            case KernelOp::BINARY: {
+                double* x = operand(top - 2);
+                if (!combine(op.op, x, operand(top - 1), count) || !narrowAll(x, count, narrow)) {
+                    return false;
+                }
+                top--;
+                break;
+            }
+
+            case KernelOp::FUNCTION: {
+                double* x = operand(top - 1);
+                try {
+                    for (int k = 0; k < count; k++) x[k] = op.function(x[k]);
+                } catch (const std::exception&) {
+                    return false;
+                }
+                if (!narrowAll(x, count, narrow)) {
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+    std::copy(operand(0), operand(0) + count, result);
+    return true;
+}
+
+void ArrayLoopAnalysis::analyze(const std::vector<std::shared_ptr<ASTNode>>& lines) {
+    std::vector<ASTNode*> statements;
+    for (const auto& line : lines) {
+        for (const auto& stmt : line->children) {
+            statements.push_back(stmt.get());
+        }
+    }
+
+    for (size_t start = 0; start < statements.size(); start++) {
+        const ASTNode& forStatement = *statements[start];
+        if (forStatement.type != NODE_STATEMENT || forStatement.keyword != KW_FOR || forStatement.children.size() < 3 ||
+            forStatement.children[0]->slot < 0 || VariableManager::isStringSlot(forStatement.children[0]->slot)) {
+            continue;
+        }
+
+        // The body is array assignments up to a NEXT for this loop
+        std::vector<ASTNode*> body;
+        size_t end = start + 1;
+        while (end < statements.size() && arrayTarget(*statements[end])) {
+            body.push_back(statements[end++]);
+        }
+        if (body.empty() || end == statements.size()) {
+            continue;
+        }
+        const ASTNode& next = *statements[end];
+        if (next.type != NODE_STATEMENT || next.keyword != KW_NEXT || next.children.size() > 1 ||
+            (next.children.size() == 1 && next.children[0]->slot != forStatement.children[0]->slot)) {
+            continue;
+        }
+
+        auto loop = compileLoop(forStatement, body);
+        if (loop) {
+            loops[&forStatement] = loop;
+        }
+    }
+}
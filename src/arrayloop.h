@@ -0,0 +1,78 @@
+#ifndef ARRAYLOOP_H
+#define ARRAYLOOP_H
+
+#include "parser.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// One step of an array loop statement's expression, in postfix order
+struct KernelOp {
+    enum Kind {
+        CONSTANT,   // A numeric literal
+        INVARIANT,  // An expression that doesn't change in the loop, evaluated on entry
+        COUNTER,    // The loop variable
+        ELEMENT,    // Array element at the loop variable plus offset
+        NEGATE,     // - of the top operand
+        NOT,        // NOT of the top operand
+        BINARY,     // The top two operands combined by op
+        FUNCTION    // A built-in function of the top operand
+    };
+
+    Kind kind;
+    double constant = 0;
+    std::shared_ptr<ASTNode> expr;          // INVARIANT
+    int slot = -1;                          // ELEMENT
+    int offset = 0;                         // ELEMENT
+    OperatorType op = OP_PLUS;              // BINARY
+    double (*function)(double) = nullptr;   // FUNCTION
+};
+
+// An assignment A(I + offset) = expr of an array loop body
+struct KernelStatement {
+    int slot;
+    int offset;
+    size_t begin, end;      // Its ops in ArrayLoop::ops
+};
+
+// A FOR loop whose body is a run of numeric array assignments, each storing to
+// its array at the loop variable plus a constant, such as
+//     FOR I = 1 TO N: A(I) = B(I) * K + C(I - 1): NEXT I
+// The body assigns no variables, and an array it assigns is only read at the
+// subscript it is assigned at, so no iteration depends on another and the body
+// can be run one statement at a time over many iterations.
+struct ArrayLoop {
+    static const int CHUNK = 256;   // Iterations computed together
+
+    int counter;
+    std::vector<KernelOp> ops;
+    std::vector<KernelStatement> statements;
+    size_t depth = 0;               // Operand stack depth the ops need
+
+    // Computes iterations first, first + step, ... (count <= CHUNK of them)
+    // of a statement into result. values holds the resolved value of each
+    // CONSTANT and INVARIANT op, and arrays the elements each ELEMENT op reads.
+    // Returns false if an operation would raise an error.
+    bool evaluate(const KernelStatement& statement, const std::vector<double>& values,
+                  const std::vector<const Value*>& arrays, int64_t first, int64_t step, int count,
+                  double (*narrow)(double), double* result, std::vector<double>& scratch) const;
+};
+
+// The program's array loops. Like LoopAnalysis, this runs once per edited
+// program and its result is shared by every interpreter running it.
+struct ArrayLoopAnalysis {
+    std::once_flag analyzed;
+    std::unordered_map<const ASTNode*, std::shared_ptr<const ArrayLoop>> loops;  // FOR statement -> loop
+
+    // Takes the program's lines in line-number order
+    void analyze(const std::vector<std::shared_ptr<ASTNode>>& lines);
+
+    const ArrayLoop* loopFor(const ASTNode* forStatement) const {
+        auto it = loops.find(forStatement);
+        return it == loops.end() ? nullptr : it->second.get();
+    }
+};
+
+#endif
@@ -0,0 +1,166 @@
+#include "batch.h"
+
+#ifndef __EMSCRIPTEN__
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+struct BatchJob {
+    std::string name;
+    unsigned int seed;
+    std::string output;
+    size_t peakMemory;
+    bool failed;
+    bool done;
+};
+
+// FNV-1a of the transcript name, so a replay gets the same RND sequence every run
+static unsigned int seedForTranscript(const std::string& name, uint32_t baseSeed) {
+    uint32_t hash = 2166136261u ^ baseSeed;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static std::string jsonEscape(const std::string& s) {
+    std::string escaped;
+    escaped.reserve(s.size() + 2);
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    escaped += buf;
+                } else {
+                    escaped += static_cast<char>(c);
+                }
+        }
+    }
+    return escaped;
+}
+
+static void runJob(const AltairBasicInterpreter& program, const BatchOptions& options, BatchJob& job) {
+    std::ifstream transcript(options.transcriptDir + "/" + job.name);
+    std::ostringstream output;
+    if (!transcript) {
+        output << "CAN'T OPEN " << job.name << std::endl;
+        job.failed = true;
+        job.output = output.str();
+        return;
+    }
+
+    AltairBasicInterpreter session;
+    session.shareProgram(program);
+    session.setStreams(transcript, output);
+    session.seedRandom(job.seed);
+    session.setSinglePrecision(options.singlePrecision);
+    session.setLoopHoisting(options.loopHoisting);
+    if (options.memoryLimit) {
+        session.setMemoryLimit(options.memoryLimit);
+    }
+
+    try {
+        session.executeRun();
+    } catch (const std::exception& e) {
+        output << "RUNTIME ERROR: " << e.what() << std::endl;
+        job.failed = true;
+    }
+    job.output = output.str();
+    job.peakMemory = session.peakMemoryUsed();
+}
+
+static bool emitJob(const BatchOptions& options, BatchJob& job) {
+    bool ok = true;
+    if (options.outputDir.empty()) {
+        *options.records << "{\"transcript\":\"" << jsonEscape(job.name) << "\",\"seed\":" << job.seed
+                  << ",\"error\":" << (job.failed ? "true" : "false")
+                  << ",\"peakMemory\":" << job.peakMemory
+                  << ",\"output\":\"" << jsonEscape(job.output) << "\"}\n";
+    } else {
+        std::string path = options.outputDir + "/" + job.name + ".out";
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << job.output;
+        if (!file) {
+            std::cerr << "CAN'T WRITE " << path << std::endl;
+            ok = false;
+        }
+    }
+    std::string().swap(job.output);
+    return ok;
+}
+
+int runBatch(const AltairBasicInterpreter& program, const BatchOptions& options) {
+    DIR* dir = opendir(options.transcriptDir.c_str());
+    if (!dir) {
+        std::cerr << "CAN'T OPEN " << options.transcriptDir << std::endl;
+        return 1;
+    }
+    std::vector<BatchJob> jobs;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        struct stat st;
+        if (name[0] == '.' || stat((options.transcriptDir + "/" + name).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        jobs.push_back({name, seedForTranscript(name, options.seed), "", 0, false, false});
+    }
+    closedir(dir);
+    std::sort(jobs.begin(), jobs.end(), [](const BatchJob& a, const BatchJob& b) { return a.name < b.name; });
+
+    unsigned workers = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min<unsigned>(workers, std::max<size_t>(jobs.size(), 1));
+
+    // Results are emitted in transcript order as soon as every earlier one has finished
+    std::atomic<size_t> next(0);
+    std::mutex emitMutex;
+    size_t nextToEmit = 0;
+    bool ok = true;
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < workers; i++) {
+        pool.emplace_back([&]() {
+            for (size_t j = next++; j < jobs.size(); j = next++) {
+                runJob(program, options, jobs[j]);
+
+                std::lock_guard<std::mutex> lock(emitMutex);
+                jobs[j].done = true;
+                while (nextToEmit < jobs.size() && jobs[nextToEmit].done) {
+                    ok = emitJob(options, jobs[nextToEmit]) && ok;
+                    ok = !jobs[nextToEmit].failed && ok;
+                    nextToEmit++;
+                }
+            }
+        });
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    options.records->flush();
+
+    return ok ? 0 : 1;
+}
+
+#else
+
+int runBatch(const AltairBasicInterpreter& program, const BatchOptions& options) {
+    return 1;
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "interpreter.h"
+#include <iostream>
+#include <string>
+
+struct BatchOptions {
+    std::string transcriptDir;
+    std::string outputDir;   // Per-transcript <name>.out files; JSONL on records when empty
+    std::ostream* records;   // Where JSONL records go
+    unsigned threads;        // 0 = one per core
+    unsigned int seed;       // Mixed into each transcript's RND seed
+    size_t memoryLimit;      // Per-session limit; 0 = interpreter default
+    bool singlePrecision;
+    bool loopHoisting;
+
+    BatchOptions() : records(&std::cout), threads(0), seed(0), memoryLimit(0), singlePrecision(false), loopHoisting(true) {}
+};
+
+// Runs an already loaded program once per transcript file, in parallel.
+// Returns the process exit status.
+int runBatch(const AltairBasicInterpreter& program, const BatchOptions& options);
+
+#endif
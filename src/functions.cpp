@@ -2,7 +2,6 @@
 #include <cmath>
 #include <stdexcept>
 #include <algorithm>
-#include <random>
 #include <sstream>
 #include <iomanip>
 
@@ -65,77 +64,47 @@ double MathFunctions::sgn(double x) {
     return 0.0;
 }
 
-double MathFunctions::rnd() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<> dis(0.0, 1.0);
-    static double lastRandom = 0.0;
-    
-    lastRandom = dis(gen);
-    return lastRandom;
-}
-
-double MathFunctions::rnd(double x) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<> dis(0.0, 1.0);
-    static double lastRandom = 0.0;
-    
-    if (x > 0) {
-        // RND(positive) - return new random number
-        lastRandom = dis(gen);
-        return lastRandom;
-    } else if (x == 0) {
-        // RND(0) - return last random number
-        return lastRandom;
-    } else {
-        // RND(negative) - seed the generator
-        gen.seed(static_cast<unsigned int>(-x));
-        lastRandom = dis(gen);
-        return lastRandom;
-    }
-}
-
 // String functions
-std::string MathFunctions::chr_func(double x) {
+Value MathFunctions::chr_func(double x) {
     int ascii = static_cast<int>(x);
     if (ascii < 0 || ascii > 255) {
         throw std::runtime_error("ILLEGAL FUNCTION CALL");
     }
-    return std::string(1, static_cast<char>(ascii));
+    char c = static_cast<char>(ascii);
+    return Value::string(StringView(&c, 1));
 }
 
-double MathFunctions::asc(const std::string& s) {
+double MathFunctions::asc(StringView s) {
     if (s.empty()) {
         throw std::runtime_error("ILLEGAL FUNCTION CALL");
     }
     return static_cast<double>(static_cast<unsigned char>(s[0]));
 }
 
-double MathFunctions::len(const std::string& s) {
-    return static_cast<double>(s.length());
+double MathFunctions::len(StringView s) {
+    return static_cast<double>(s.size());
 }
 
-std::string MathFunctions::left_func(const std::string& s, double n) {
+StringView MathFunctions::left_func(StringView s, double n) {
     int count = static_cast<int>(n);
     if (count < 0) count = 0;
-    if (count > static_cast<int>(s.length())) count = s.length();
+    if (count > static_cast<int>(s.size())) count = s.size();
     return s.substr(0, count);
 }
 
-std::string MathFunctions::right_func(const std::string& s, double n) {
+StringView MathFunctions::right_func(StringView s, double n) {
     int count = static_cast<int>(n);
     if (count < 0) count = 0;
-    if (count > static_cast<int>(s.length())) count = s.length();
-    return s.substr(s.length() - count, count);
+    if (count > static_cast<int>(s.size())) count = s.size();
+    return s.substr(s.size() - count, count);
 }
 
-std::string MathFunctions::mid_func(const std::string& s, double start, double length) {
+StringView MathFunctions::mid_func(StringView s, double start, double length) {
     int startPos = static_cast<int>(start) - 1; // BASIC uses 1-based indexing
     int len = static_cast<int>(length);
     if (startPos < 0) startPos = 0;
     if (len < 0) len = 0;
-    if (startPos >= static_cast<int>(s.length())) return "";
+    if (startPos >= static_cast<int>(s.size())) return StringView();
     return s.substr(startPos, len);
 }
 
@@ -153,14 +122,45 @@ std::string MathFunctions::str_func(double x) {
     return oss.str();
 }
 
-double MathFunctions::val(const std::string& s) {
+double MathFunctions::val(StringView s) {
     try {
-        return std::stod(s);
+        return std::stod(s.str());
     } catch (const std::exception&) {
         return 0.0; // Invalid strings return 0 in BASIC
     }
 }
 
+double MathFunctions::operate(OperatorType op, double left, double right) {
+    switch (op) {
+        case OP_PLUS: return left + right;
+        case OP_MINUS: return left - right;
+        case OP_MULTIPLY: return left * right;
+        case OP_DIVIDE:
+            if (right == 0.0) throw std::runtime_error("DIVISION BY ZERO");
+            return left / right;
+        case OP_POWER: return std::pow(left, right);
+        case OP_EQUAL: return (left == right) ? -1.0 : 0.0;
+        case OP_NOT_EQUAL: return (left != right) ? -1.0 : 0.0;
+        case OP_LESS: return (left < right) ? -1.0 : 0.0;
+        case OP_LESS_EQUAL: return (left <= right) ? -1.0 : 0.0;
+        case OP_GREATER: return (left > right) ? -1.0 : 0.0;
+        case OP_GREATER_EQUAL: return (left >= right) ? -1.0 : 0.0;
+        case OP_AND: return (left != 0.0 && right != 0.0) ? -1.0 : 0.0;
+        case OP_OR: return (left != 0.0 || right != 0.0) ? -1.0 : 0.0;
+        case OP_SQUARE: return left * left;
+        case OP_CUBE: return left * left * left;
+        case OP_FOURTH_POWER: {
+            double square = left * left;
+            return square * square;
+        }
+        case OP_SQUARE_ROOT:
+            // X^.5, except that pow gives +0 for -0 and +INF for -INF
+            return std::isinf(left) ? HUGE_VAL : std::sqrt(left) + 0.0;
+        case OP_DIVIDE_NONZERO: return left / right;
+        default: throw std::runtime_error("SYNTAX ERROR");
+    }
+}
+
 bool MathFunctions::isMathFunction(const std::string& name) {
     std::string upperName = name;
     std::transform(upperName.begin(), upperName.end(), upperName.begin(), ::toupper);
@@ -169,7 +169,8 @@ bool MathFunctions::isMathFunction(const std::string& name) {
            upperName == "SIN" || upperName == "COS" || upperName == "ATN" ||
            upperName == "EXP" || upperName == "LOG" || upperName == "SGN" ||
            upperName == "TAB" || upperName == "USR" || upperName == "RND" ||
-           upperName == "ASC" || upperName == "LEN" || upperName == "VAL";
+           upperName == "ASC" || upperName == "LEN" || upperName == "VAL" ||
+           upperName == "FRE";
 }
 
 bool MathFunctions::isStringFunction(const std::string& name) {
@@ -218,13 +219,11 @@ double MathFunctions::callFunction(const std::string& name, const std::vector<do
         if (args.size() != 1) throw std::runtime_error("SYNTAX ERROR");
         return usr(args[0]);
     } else if (upperName == "RND") {
-        if (args.size() == 0) {
-            return rnd();
-        } else if (args.size() == 1) {
-            return rnd(args[0]);
-        } else {
-            throw std::runtime_error("SYNTAX ERROR");
-        }
+        // Handled in interpreter, which owns the random number generator
+        throw std::runtime_error("UNDEFINED FUNCTION");
+    } else if (upperName == "FRE") {
+        // Handled in interpreter, which does the memory accounting
+        throw std::runtime_error("UNDEFINED FUNCTION");
     } else if (upperName == "ASC") {
         // Handled in interpreter for string arguments
         throw std::runtime_error("UNDEFINED FUNCTION");
@@ -239,7 +238,7 @@ double MathFunctions::callFunction(const std::string& name, const std::vector<do
     throw std::runtime_error("UNDEFINED FUNCTION");
 }
 
-std::string MathFunctions::callStringFunction(const std::string& name, const std::vector<double>& numArgs, const std::vector<std::string>& strArgs) {
+Value MathFunctions::callStringFunction(const std::string& name, const std::vector<double>& numArgs, const std::vector<Value>& strArgs) {
     std::string upperName = name;
     std::transform(upperName.begin(), upperName.end(), upperName.begin(), ::toupper);
     
@@ -248,16 +247,16 @@ std::string MathFunctions::callStringFunction(const std::string& name, const std
         return chr_func(numArgs[0]);
     } else if (upperName == "LEFT$") {
         if (strArgs.size() != 1 || numArgs.size() != 1) throw std::runtime_error("SYNTAX ERROR");
-        return left_func(strArgs[0], numArgs[0]);
+        return Value::string(left_func(strArgs[0].text(), numArgs[0]));
     } else if (upperName == "RIGHT$") {
         if (strArgs.size() != 1 || numArgs.size() != 1) throw std::runtime_error("SYNTAX ERROR");
-        return right_func(strArgs[0], numArgs[0]);
+        return Value::string(right_func(strArgs[0].text(), numArgs[0]));
     } else if (upperName == "MID$") {
         if (strArgs.size() != 1 || numArgs.size() != 2) throw std::runtime_error("SYNTAX ERROR");
-        return mid_func(strArgs[0], numArgs[0], numArgs[1]);
+        return Value::string(mid_func(strArgs[0].text(), numArgs[0], numArgs[1]));
     } else if (upperName == "STR$") {
         if (numArgs.size() != 1) throw std::runtime_error("SYNTAX ERROR");
-        return str_func(numArgs[0]);
+        return Value::string(str_func(numArgs[0]));
     }
     
     throw std::runtime_error("UNDEFINED FUNCTION");
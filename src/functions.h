@@ -1,6 +1,8 @@
 #ifndef FUNCTIONS_H
 #define FUNCTIONS_H
 
+#include "lexer.h"
+#include "value.h"
 #include <string>
 #include <vector>
 
@@ -17,23 +19,24 @@ public:
     static double sgn(double x);
     static double tab(double x);
     static double usr(double x);
-    static double rnd();
-    static double rnd(double x);
     
     // String functions
-    static std::string chr_func(double x);
-    static double asc(const std::string& s);
-    static double len(const std::string& s);
-    static std::string left_func(const std::string& s, double n);
-    static std::string right_func(const std::string& s, double n);
-    static std::string mid_func(const std::string& s, double start, double length);
+    static Value chr_func(double x);
+    static double asc(StringView s);
+    static double len(StringView s);
+    static StringView left_func(StringView s, double n);
+    static StringView right_func(StringView s, double n);
+    static StringView mid_func(StringView s, double start, double length);
     static std::string str_func(double x);
-    static double val(const std::string& s);
+    static double val(StringView s);
+    
+    // A numeric binary operator; comparisons and logic give -1 for true, 0 for false
+    static double operate(OperatorType op, double left, double right);
     
     static bool isMathFunction(const std::string& name);
     static bool isStringFunction(const std::string& name);
     static double callFunction(const std::string& name, const std::vector<double>& args);
-    static std::string callStringFunction(const std::string& name, const std::vector<double>& numArgs, const std::vector<std::string>& strArgs);
+    static Value callStringFunction(const std::string& name, const std::vector<double>& numArgs, const std::vector<Value>& strArgs);
 };
 
 #endif
@@ -0,0 +1,245 @@
+#include "hoist.h"
+#include <set>
+
+namespace {
+
+// Variable and array slots a loop body can change
+struct Assignments {
+    std::set<int> scalars;
+    std::set<int> arrays;
+
+    void target(const ASTNode& var) {
+        if (var.type == NODE_ARRAY_ACCESS && !var.children.empty()) {
+            arrays.insert(var.children[0]->slot);
+        } else {
+            scalars.insert(var.slot);
+        }
+    }
+};
+
+void clearHoistSlots(ASTNode& node) {
+    node.hoistSlot = -1;
+    for (auto& child : node.children) {
+        clearHoistSlots(*child);
+    }
+}
+
+// Records what a body statement assigns. Returns false if it can transfer
+// control out of the body or change state the analysis doesn't track.
+bool scanStatement(const ASTNode& stmt, Assignments& assigned) {
+    if (stmt.type == NODE_ON_ERROR_GOTO) {
+        return false;
+    }
+
+    switch (stmt.keyword) {
+        case KW_LET:
+            if (!stmt.children.empty() && stmt.children[0]->children.size() == 2) {
+                assigned.target(*stmt.children[0]->children[0]);
+            }
+            return true;
+
+        case KW_FOR:
+            if (!stmt.children.empty()) {
+                assigned.target(*stmt.children[0]);
+            }
+            return true;
+
+        case KW_NEXT:
+            return stmt.children.size() <= 1;
+
+        case KW_READ:
+        case KW_INPUT:
+            if (!stmt.children.empty()) {
+                for (const auto& var : stmt.children.back()->children) {
+                    assigned.target(*var);
+                }
+            }
+            return true;
+
+        case KW_DIM:
+            for (const auto& declaration : stmt.children) {
+                if (!declaration->children.empty()) {
+                    assigned.arrays.insert(declaration->children[0]->slot);
+                }
+            }
+            return true;
+
+        case KW_IF:
+            for (size_t i = 1; i < stmt.children.size(); i++) {
+                // A FOR or NEXT that only runs on some iterations makes the
+                // loop structure dynamic
+                const ASTNode& consequent = *stmt.children[i];
+                if (consequent.keyword == KW_FOR || consequent.keyword == KW_NEXT ||
+                    !scanStatement(consequent, assigned)) {
+                    return false;
+                }
+            }
+            return true;
+
+        case KW_PRINT:
+        case KW_DATA:
+        case KW_RESTORE:
+        case KW_END:
+        case KW_STOP:
+        case KW_REM:
+        case KW_RANDOMIZE:
+            return true;
+
+        default:
+            return false; // GOTO, GOSUB, RETURN, ON, DEF and the commands
+    }
+}
+
+// Whether an expression reads only what the body leaves unchanged and has no
+// side effects
+bool isInvariant(const ASTNode& node, const Assignments& assigned) {
+    size_t first = 0;
+    switch (node.type) {
+        case NODE_NUMBER:
+        case NODE_STRING:
+            return true;
+
+        case NODE_VARIABLE:
+            return assigned.scalars.count(node.slot) == 0;
+
+        case NODE_ARRAY_ACCESS:
+            // An FN call depends on whichever DEF ran last
+            if (node.slot >= 0 || node.children.size() < 2 || node.children[0]->slot < 0 ||
+                assigned.arrays.count(node.children[0]->slot) != 0) {
+                return false;
+            }
+            first = 1;
+            break;
+
+        case NODE_FUNCTION_CALL:
+            // RND and FRE differ from call to call, TAB moves the cursor
+            if (node.value == "RND" || node.value == "FRE" || node.value == "TAB" || node.value == "USR") {
+                return false;
+            }
+            break;
+
+        case NODE_BINARY_OP:
+        case NODE_UNARY_OP:
+        case NODE_STRING_FUNCTION_CALL:
+            break;
+
+        default:
+            return false;
+    }
+
+    for (size_t i = first; i < node.children.size(); i++) {
+        if (!isInvariant(*node.children[i], assigned)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Gives the largest invariant subtrees of an expression a hoist slot cached
+// for loop. Loops are visited outermost first, so a subtree that is invariant
+// in an enclosing loop keeps that loop's slot.
+void claim(ASTNode& node, int loop, const Assignments& assigned, std::vector<int>& slotLoops) {
+    if (node.hoistSlot >= 0 || node.type == NODE_NUMBER || node.type == NODE_STRING || node.type == NODE_VARIABLE) {
+        return;
+    }
+    if (isInvariant(node, assigned)) {
+        node.hoistSlot = static_cast<int>(slotLoops.size());
+        slotLoops.push_back(loop);
+        return;
+    }
+    for (size_t i = node.type == NODE_ARRAY_ACCESS ? 1 : 0; i < node.children.size(); i++) {
+        claim(*node.children[i], loop, assigned, slotLoops);
+    }
+}
+
+// Claims the expressions a statement evaluates
+void claimStatement(ASTNode& stmt, int loop, const Assignments& assigned, std::vector<int>& slotLoops) {
+    switch (stmt.keyword) {
+        case KW_LET:
+            if (!stmt.children.empty() && stmt.children[0]->children.size() == 2) {
+                ASTNode& target = *stmt.children[0]->children[0];
+                for (size_t i = 1; target.type == NODE_ARRAY_ACCESS && i < target.children.size(); i++) {
+                    claim(*target.children[i], loop, assigned, slotLoops);
+                }
+                claim(*stmt.children[0]->children[1], loop, assigned, slotLoops);
+            }
+            break;
+
+        case KW_PRINT:
+            for (auto& item : stmt.children) {
+                claim(*item, loop, assigned, slotLoops);
+            }
+            break;
+
+        case KW_FOR:
+            for (size_t i = 1; i < stmt.children.size(); i++) {
+                claim(*stmt.children[i], loop, assigned, slotLoops);
+            }
+            break;
+
+        case KW_IF:
+            for (size_t i = 0; i < stmt.children.size(); i++) {
+                if (i == 0) {
+                    claim(*stmt.children[i], loop, assigned, slotLoops);
+                } else {
+                    claimStatement(*stmt.children[i], loop, assigned, slotLoops);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+} // namespace
+
+void LoopAnalysis::analyze(const std::vector<std::shared_ptr<ASTNode>>& lines) {
+    std::vector<ASTNode*> statements;
+    for (const auto& line : lines) {
+        clearHoistSlots(*line);
+        for (const auto& stmt : line->children) {
+            statements.push_back(stmt.get());
+        }
+    }
+
+    for (size_t start = 0; start < statements.size(); start++) {
+        ASTNode& forStatement = *statements[start];
+        if (forStatement.type != NODE_STATEMENT || forStatement.keyword != KW_FOR || forStatement.children.size() < 3) {
+            continue;
+        }
+
+        // The body runs to the NEXT that closes this FOR in program order
+        Assignments assigned;
+        assigned.target(*forStatement.children[0]);
+        bool straight = true;
+        size_t end = start + 1;
+        for (int depth = 0; end < statements.size(); end++) {
+            const ASTNode& stmt = *statements[end];
+            if (stmt.type == NODE_STATEMENT && stmt.keyword == KW_NEXT && depth-- == 0) {
+                break;
+            }
+            if (stmt.type == NODE_STATEMENT && stmt.keyword == KW_FOR) {
+                depth++;
+            }
+            straight = straight && scanStatement(stmt, assigned);
+        }
+        if (!straight || end == statements.size()) {
+            continue;
+        }
+        const ASTNode& next = *statements[end];
+        if (!next.children.empty() && next.children[0]->value != forStatement.children[0]->value) {
+            continue;
+        }
+
+        int loop = loopCount;
+        size_t slots = slotLoops.size();
+        for (size_t i = start + 1; i < end; i++) {
+            claimStatement(*statements[i], loop, assigned, slotLoops);
+        }
+        if (slotLoops.size() > slots) {
+            loopIds[&forStatement] = loop;
+            loopCount++;
+        }
+    }
+}
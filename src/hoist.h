@@ -0,0 +1,34 @@
+#ifndef HOIST_H
+#define HOIST_H
+
+#include "parser.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Loop-invariant expressions of a program. A FOR loop whose body is a straight
+// run of statements up to its NEXT (no jumps, subroutines or DEFs) is given
+// a loop id, and the largest subexpressions of its body that read nothing the
+// body assigns are given a hoistSlot. The interpreter evaluates a hoisted
+// expression the first time it is reached after the loop is entered and reuses
+// the value until the loop is entered again.
+//
+// The analysis writes hoistSlot into the AST, so it runs once per edited
+// program and is shared by every interpreter running that program.
+struct LoopAnalysis {
+    std::once_flag analyzed;
+    std::unordered_map<const ASTNode*, int> loopIds;   // FOR statement -> loop id
+    std::vector<int> slotLoops;                         // Hoist slot -> loop it is cached for
+    int loopCount = 0;
+
+    // Takes the program's lines in line-number order
+    void analyze(const std::vector<std::shared_ptr<ASTNode>>& lines);
+
+    int loopFor(const ASTNode* forStatement) const {
+        auto it = loopIds.find(forStatement);
+        return it == loopIds.end() ? -1 : it->second;
+    }
+};
+
+#endif
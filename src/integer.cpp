@@ -0,0 +1,197 @@
+#include "integer.h"
+#include <cmath>
+
+namespace {
+
+// Integers a double holds exactly
+const double EXACT_LIMIT = 9007199254740992.0;
+
+void collectStatements(ASTNode& stmt, std::vector<ASTNode*>& statements) {
+    statements.push_back(&stmt);
+    if (stmt.type == NODE_STATEMENT && stmt.keyword == KW_IF) {
+        for (size_t i = 1; i < stmt.children.size(); i++) {
+            collectStatements(*stmt.children[i], statements);
+        }
+    }
+}
+
+void clearFlags(ASTNode& node) {
+    node.integral = false;
+    for (auto& child : node.children) {
+        clearFlags(*child);
+    }
+}
+
+// Whether evaluating an expression twice gives the same value: no RND, FRE,
+// TAB, USR or FN calls
+bool isPure(const ASTNode& node) {
+    if (node.type == NODE_FUNCTION_CALL &&
+        (node.value == "RND" || node.value == "FRE" || node.value == "TAB" || node.value == "USR")) {
+        return false;
+    }
+    if (node.type == NODE_ARRAY_ACCESS && node.slot >= 0) {
+        return false;
+    }
+    for (const auto& child : node.children) {
+        if (!isPure(*child)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isNumericVariable(const ASTNode& node) {
+    return node.type == NODE_VARIABLE && node.slot >= 0 && !VariableManager::isStringSlot(node.slot);
+}
+
+bool isIntegral(const ASTNode& node, const std::vector<bool>& integerVariables) {
+    switch (node.type) {
+        case NODE_NUMBER: {
+            if (node.text.isString()) {
+                return false;
+            }
+            double value = node.text.number();
+            return std::fabs(value) <= EXACT_LIMIT && value == std::trunc(value);
+        }
+
+        case NODE_VARIABLE:
+            // A name that can never be assigned reads as 0
+            if (node.slot < 0) {
+                return node.value.back() != '$';
+            }
+            return isNumericVariable(node) && integerVariables[node.slot];
+
+        case NODE_UNARY_OP:
+            return node.children.size() == 1 && (node.operator_type == OP_MINUS || node.value == "NOT") &&
+                   isIntegral(*node.children[0], integerVariables);
+
+        case NODE_BINARY_OP:
+            if (node.children.size() != 2) {
+                return false;
+            }
+            switch (node.operator_type) {
+                case OP_SQUARE:
+                case OP_CUBE:
+                case OP_FOURTH_POWER:
+                    return isIntegral(*node.children[0], integerVariables);
+
+                case OP_PLUS:
+                case OP_MINUS:
+                case OP_MULTIPLY:
+                case OP_EQUAL:
+                case OP_NOT_EQUAL:
+                case OP_LESS:
+                case OP_LESS_EQUAL:
+                case OP_GREATER:
+                case OP_GREATER_EQUAL:
+                case OP_AND:
+                case OP_OR:
+                    return isIntegral(*node.children[0], integerVariables) &&
+                           isIntegral(*node.children[1], integerVariables);
+
+                default:
+                    return false;
+            }
+
+        case NODE_FUNCTION_CALL:
+            if (node.children.size() != 1) {
+                return false;
+            }
+            if (node.value == "INT") {
+                // The argument may be evaluated again if the result is out of range
+                return isPure(*node.children[0]);
+            }
+            return (node.value == "ABS" || node.value == "SGN") && isIntegral(*node.children[0], integerVariables);
+
+        default:
+            return false;
+    }
+}
+
+// Rules out the variables a statement can set to something other than an
+// integer. Returns whether any were.
+bool excludeAssigned(const ASTNode& stmt, std::vector<bool>& integerVariables) {
+    auto exclude = [&integerVariables](const ASTNode& var) {
+        if (isNumericVariable(var) && integerVariables[var.slot]) {
+            integerVariables[var.slot] = false;
+            return true;
+        }
+        return false;
+    };
+
+    if (stmt.type != NODE_STATEMENT) {
+        return false;
+    }
+    switch (stmt.keyword) {
+        case KW_LET:
+            if (!stmt.children.empty() && stmt.children[0]->children.size() == 2 &&
+                !isIntegral(*stmt.children[0]->children[1], integerVariables)) {
+                return exclude(*stmt.children[0]->children[0]);
+            }
+            return false;
+
+        case KW_FOR:
+            if (stmt.children.size() >= 3 &&
+                (!isIntegral(*stmt.children[1], integerVariables) ||
+                 (stmt.children.size() > 3 && !isIntegral(*stmt.children[3], integerVariables)))) {
+                return exclude(*stmt.children[0]);
+            }
+            return false;
+
+        case KW_READ:
+        case KW_INPUT: {
+            bool changed = false;
+            if (!stmt.children.empty()) {
+                for (const auto& var : stmt.children.back()->children) {
+                    changed = exclude(*var) || changed;
+                }
+            }
+            return changed;
+        }
+
+        default:
+            return false;
+    }
+}
+
+void mark(ASTNode& node, const std::vector<bool>& integerVariables) {
+    if (node.children.empty()) {
+        return;
+    }
+    node.integral = isIntegral(node, integerVariables);
+    for (auto& child : node.children) {
+        mark(*child, integerVariables);
+    }
+}
+
+} // namespace
+
+void IntegerAnalysis::analyze(const std::vector<std::shared_ptr<ASTNode>>& lines) {
+    std::vector<ASTNode*> statements;
+    for (const auto& line : lines) {
+        clearFlags(*line);
+        for (const auto& stmt : line->children) {
+            collectStatements(*stmt, statements);
+        }
+    }
+
+    // Start from every variable being integral and rule out the ones some
+    // statement breaks, until what remains is consistent
+    std::vector<bool> integerVariables(VariableManager::NUMERIC_SLOTS, true);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const ASTNode* stmt : statements) {
+            changed = excludeAssigned(*stmt, integerVariables) || changed;
+        }
+    }
+
+    for (const auto& line : lines) {
+        for (const auto& stmt : line->children) {
+            // DATA items are text until they are READ
+            if (stmt->type == NODE_STATEMENT && stmt->keyword == KW_DATA) {
+                continue;
+            }
+            mark(*stmt, integerVariables);
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef INTEGER_H
+#define INTEGER_H
+
+#include "parser.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Integer-valued expressions of a program. A numeric variable is integral if
+// every statement that assigns it stores an integer: a FOR with an integer
+// start and step, or a LET of an integral expression. Literals, integral
+// variables, and sums, products, comparisons, NOT, INT, ABS and SGN of
+// integral operands are integral, and each such operator node is given the
+// integral flag. The interpreter evaluates flagged expressions with 64-bit
+// integer arithmetic and converts to a double only for the result.
+//
+// The flag only says where the integer path is worth trying. At run time
+// every operand is checked to be an integer in the range a double holds
+// exactly, and anything else falls back to floating point, so the results
+// are always the same. Like LoopAnalysis, this runs once per edited program.
+struct IntegerAnalysis {
+    std::once_flag analyzed;
+
+    // Takes the program's lines in line-number order
+    void analyze(const std::vector<std::shared_ptr<ASTNode>>& lines);
+};
+
+#endif
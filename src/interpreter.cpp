@@ -1,10 +1,18 @@
 #include "interpreter.h"
+#include "spill.h"
+#include "optimize.h"
+#include "print.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 #include <cmath>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <set>
+#include <unistd.h>
 
 #ifdef __EMSCRIPTEN__
 #include <sstream> // Required for std::stringstream
@@ -14,19 +22,103 @@ extern "C" {
     void await_input_from_js();
     const char* get_input_buffer();
 }
+#else
+#include <poll.h>
 #endif
 
 AltairBasicInterpreter::AltairBasicInterpreter() 
-    : dataPointer(0), currentLine(-1), currentStatementIndex(0), running(false), stopExecution(false), returningFromSubroutine(false), debug(false), m_currentColumn(0), on_error_goto_line(-1) {}
+    : dataPointer(0), dataTableStale(true), userFunctions(VariableManager::NUMERIC_SLOTS), functionArgument(0), currentLine(-1), currentStatementIndex(0), running(false), stopExecution(false), returningFromSubroutine(false), debug(false), m_currentColumn(0), on_error_goto_line(-1), idleSpillSeconds(0), singlePrecision(false), loopHoisting(true), hoistingActive(false), loopAnalysis(std::make_shared<LoopAnalysis>()), activationCounter(0), integersActive(false), integerAnalysis(std::make_shared<IntegerAnalysis>()), arrayLoopsActive(false), arrayLoopAnalysis(std::make_shared<ArrayLoopAnalysis>()), jumpsActive(false), jumpAnalysis(std::make_shared<JumpAnalysis>()), memoryLimit(DEFAULT_MEMORY_LIMIT), peakMemory(0), programBytes(0), memoryReport(nullptr), in(&std::cin), out(&std::cout), nonBlockingInput(false), inputClosed(false) {}
+
+void AltairBasicInterpreter::setStreams(std::istream& input, std::ostream& output) {
+    in = &input;
+    out = &output;
+}
+
+void AltairBasicInterpreter::shareProgram(const AltairBasicInterpreter& other) {
+    // Lines are shared, not copied: the AST is never modified while running
+    program = other.program;
+    programBytes = other.programBytes;
+    dataTableStale = true;
+    loopAnalysis = other.loopAnalysis;
+    integerAnalysis = other.integerAnalysis;
+    arrayLoopAnalysis = other.arrayLoopAnalysis;
+    jumpAnalysis = other.jumpAnalysis;
+}
+
+// Tables derived from the program are rebuilt before it next runs
+void AltairBasicInterpreter::programChanged() {
+    dataTableStale = true;
+    loopAnalysis = std::make_shared<LoopAnalysis>();
+    hoistingActive = false;
+    integerAnalysis = std::make_shared<IntegerAnalysis>();
+    integersActive = false;
+    arrayLoopAnalysis = std::make_shared<ArrayLoopAnalysis>();
+    arrayLoopsActive = false;
+    jumpAnalysis = std::make_shared<JumpAnalysis>();
+    jumpsActive = false;
+}
+
+// Approximate heap footprint of a parsed line. Interned literals are counted
+// here, since the variables that share them don't count them.
+static size_t astBytes(const ASTNode& node) {
+    size_t bytes = sizeof(ASTNode) + node.value.capacity() + node.text.blockBytes();
+    for (const auto& child : node.children) {
+        bytes += sizeof(child) + astBytes(*child);
+    }
+    return bytes;
+}
+
+size_t AltairBasicInterpreter::memoryUsed() const {
+    return programBytes + variables.bytesUsed() +
+           dataItems.size() * sizeof(DataItem) +
+           dataLineOffsets.size() * (sizeof(int) + sizeof(size_t)) +
+           callStack.size() * sizeof(CallFrame) +
+           forLoopStack.size() * sizeof(ForLoopState);
+}
+
+// Raises OUT OF MEMORY if another extra bytes would exceed the session limit.
+// Called wherever usage can grow, so the recorded peak is exact.
+void AltairBasicInterpreter::checkMemory(size_t extra) {
+    size_t used = memoryUsed();
+    if (extra > memoryLimit || used > memoryLimit - extra) {
+        throw std::runtime_error("OUT OF MEMORY");
+    }
+    peakMemory = std::max(peakMemory, used + extra);
+}
+
+void AltairBasicInterpreter::reportPeakMemory() {
+    if (memoryReport) {
+        *memoryReport << "PEAK MEMORY: " << peakMemory << " BYTES" << std::endl;
+    }
+}
 
 void AltairBasicInterpreter::processLine(const std::string& input) {
+    if (isSpilled()) {
+        try {
+            rehydrateSession();
+        } catch (const std::exception& e) {
+            // The INPUT this line would have answered is gone with the program
+            *out << e.what() << std::endl;
+            if (running) {
+                running = false;
+                *out << "OK" << std::endl;
+            }
+            return;
+        }
+    }
+    if (pendingInput) {
+        // The program is suspended in INPUT, so this line is its answer
+        completeInput(&input);
+        return;
+    }
+
     if (input == "DEBUG ON") {
         debug = true;
-        std::cout << "Debugging enabled." << std::endl;
+        *out << "Debugging enabled." << std::endl;
         return;
     } else if (input == "DEBUG OFF") {
         debug = false;
-        std::cout << "Debugging disabled." << std::endl;
+        *out << "Debugging disabled." << std::endl;
         return;
     }
 
@@ -41,6 +133,7 @@ void AltairBasicInterpreter::processLine(const std::string& input) {
         }
         
         auto line = ast->children[0];
+        optimizeLine(*line, singlePrecision ? &toSingle : nullptr);
         
         if (isDirectMode(line)) {
             // Direct mode - execute immediately
@@ -49,14 +142,20 @@ void AltairBasicInterpreter::processLine(const std::string& input) {
             }
             
             auto stmt = line->children[0];
-            if (isCommand(stmt)) {
-                executeStatement(stmt);
-            } else {
-                executeLine(line);
+            try {
+                if (isCommand(stmt)) {
+                    executeStatement(stmt);
+                } else {
+                    executeLine(line);
+                }
+            } catch (const InputSuspended&) {
+                // Direct-mode INPUT; the rest of the line runs when input arrives
+                suspendedLine = line;
+                return;
             }
             
             if (!running) {
-                std::cout << "OK" << std::endl;
+                *out << "OK" << std::endl;
             }
         } else {
             // Indirect mode - store in program
@@ -67,17 +166,93 @@ void AltairBasicInterpreter::processLine(const std::string& input) {
             
             if (line->children.empty()) {
                 // Delete line
-                program.erase(lineNum);
+                auto existing = program.find(lineNum);
+                if (existing != program.end()) {
+                    programBytes -= existing->second.bytes;
+                    program.erase(existing);
+                    programChanged();
+                }
             } else {
                 // Store line
-                program.emplace(lineNum, ProgramLine(lineNum, line));
+                size_t bytes = astBytes(*line);
+                checkMemory(bytes);
+                if (program.emplace(lineNum, ProgramLine(lineNum, line, bytes)).second) {
+                    programBytes += bytes;
+                    programChanged();
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        *out << e.what() << std::endl;
+        if (running) {
+            running = false;
+            *out << "OK" << std::endl;
+        }
+    }
+}
+
+void AltairBasicInterpreter::setNonBlockingInput(bool enabled) {
+    nonBlockingInput = enabled;
+}
+
+void AltairBasicInterpreter::closeInput() {
+    inputClosed = true;
+    if (pendingInput) {
+        completeInput(nullptr);
+    }
+}
+
+void AltairBasicInterpreter::completeInput(const std::string* line) {
+    try {
+        // A null line is end of input: the INPUT finishes without assigning anything
+        if (line && !acceptInputLine(pendingInput, *line, pendingValues)) {
+            return; // Still waiting for more values or a valid retry
+        }
+        pendingInput.reset();
+        pendingValues.clear();
+        
+        if (running) {
+            runProgram(true);
+        } else {
+            auto directLine = suspendedLine;
+            suspendedLine.reset();
+            try {
+                int originalLine = currentLine;
+                runPendingStatements();
+                if (!running && currentLine == originalLine) {
+                    currentStatementIndex++;
+                    executeLine(directLine);
+                }
+            } catch (const InputSuspended&) {
+                if (!running) {
+                    suspendedLine = directLine;
+                }
+                return;
             }
         }
+        
+        if (!running) {
+            *out << "OK" << std::endl;
+        }
     } catch (const std::exception& e) {
-        std::cout << e.what() << std::endl;
+        pendingStatements.clear();
+        *out << e.what() << std::endl;
         if (running) {
             running = false;
-            std::cout << "OK" << std::endl;
+            *out << "OK" << std::endl;
+        }
+    }
+}
+
+void AltairBasicInterpreter::runPendingStatements() {
+    std::vector<std::shared_ptr<ASTNode>> statements;
+    statements.swap(pendingStatements);
+    for (size_t i = 0; i < statements.size(); i++) {
+        try {
+            executeStatement(statements[i]);
+        } catch (const InputSuspended&) {
+            pendingStatements.insert(pendingStatements.end(), statements.begin() + i + 1, statements.end());
+            throw;
         }
     }
 }
@@ -171,6 +346,12 @@ void AltairBasicInterpreter::executeStatement(std::shared_ptr<ASTNode> stmt) {
         case KW_DEF:
             executeDef(stmt);
             break;
+        case KW_RANDOMIZE:
+            executeRandomize(stmt);
+            break;
+        case KW_MAT:
+            executeMat(stmt);
+            break;
         case KW_REM:
             // Comments do nothing
             break;
@@ -179,98 +360,88 @@ void AltairBasicInterpreter::executeStatement(std::shared_ptr<ASTNode> stmt) {
     }
 }
 
+// Runs the statement's PRINT plan, compiled when its line was entered. The
+// output goes to a line buffer that is written out in one piece.
 void AltairBasicInterpreter::executePrint(std::shared_ptr<ASTNode> stmt) {
-    bool newlineAtEnd = true;
-
-    // Check if the statement contains anything other than TAB calls and separators
-    bool hasContent = false;
-    for (const auto& child : stmt->children) {
-        if (child->type == NODE_FUNCTION_CALL && child->value == "TAB") {
-            continue;
-        }
-        if (child->type == NODE_STRING && (child->value == "," || child->value == ";")) {
-            continue;
-        }
-        hasContent = true;
-        break;
+    const PrintPlan* plan = stmt->plan.get();
+    std::shared_ptr<const PrintPlan> compiled;
+    if (!plan) {
+        compiled = compilePrint(*stmt);
+        plan = compiled.get();
     }
-
-    for (size_t i = 0; i < stmt->children.size(); ++i) {
-        auto child = stmt->children[i];
-        
-        if (child->type == NODE_STRING) {
-            if (child->value == ",") {
-                // Tab to next print zone (every 14 characters)
-                int nextZone = ((m_currentColumn / 14) + 1) * 14;
-                int spaces = nextZone - m_currentColumn;
-                for (int j = 0; j < spaces; j++) {
-                    std::cout << " ";
+    
+    printBuffer.clear();
+    try {
+        for (const PrintItem& item : plan->items) {
+            switch (item.kind) {
+                case PrintItem::TEXT: {
+                    StringView text = item.text.text();
+                    printBuffer.append(text.data(), text.size());
+                    m_currentColumn += text.size();
+                    break;
                 }
-                m_currentColumn = nextZone;
-            } else if (child->value == ";") {
-                // Semicolon only suppresses newline if it's the last item
-                if (i == stmt->children.size() - 1) {
-                    newlineAtEnd = false;
+                
+                case PrintItem::ZONE: {
+                    // Tab to next print zone (every 14 characters)
+                    int nextZone = ((m_currentColumn / 14) + 1) * 14;
+                    printBuffer.append(nextZone - m_currentColumn, ' ');
+                    m_currentColumn = nextZone;
+                    break;
+                }
+                
+                case PrintItem::TAB: {
+                    // TAB is 1-indexed, so subtract 1. TAB(1) goes to column 0.
+                    int targetColumn = static_cast<int>(evaluateExpression(item.expr)) - 1;
+                    if (targetColumn < 0) targetColumn = 0;
+                    if (targetColumn > 255) targetColumn = 255;
+                    
+                    // A TAB to a column already passed does nothing
+                    if (targetColumn > m_currentColumn) {
+                        printBuffer.append(targetColumn - m_currentColumn, ' ');
+                        m_currentColumn = targetColumn;
+                    }
+                    break;
                 }
-                // Otherwise, semicolon just means no spacing between items
-            } else {
-                std::cout << child->value;
-                m_currentColumn += child->value.length();
-            }
-        } else if (child->type == NODE_FUNCTION_CALL && child->value == "TAB") {
-            // Special handling for TAB() function
-            if (!child->children.empty()) {
-                // TAB is 1-indexed, so subtract 1. TAB(1) goes to column 0.
-                int targetColumn = static_cast<int>(evaluateExpression(child->children[0])) - 1;
-                if (targetColumn < 0) targetColumn = 0;
-                if (targetColumn > 255) targetColumn = 255;
                 
-                if (targetColumn > m_currentColumn) {
-                    int spaces = targetColumn - m_currentColumn;
-                    for (int j = 0; j < spaces; j++) {
-                        std::cout << " ";
+                case PrintItem::STRING: {
+                    // String literals, variables, array elements and functions print without copying
+                    Value scratch;
+                    StringView output = evaluateStringView(item.expr, scratch);
+                    printBuffer.append(output.data(), output.size());
+                    m_currentColumn += output.size();
+                    break;
+                }
+                
+                case PrintItem::VALUE: {
+                    // Anything else prints as whatever its value turns out to be, e.g. A$ + B$
+                    Value value = evaluate(item.expr);
+                    if (value.isString()) {
+                        StringView output = value.text();
+                        printBuffer.append(output.data(), output.size());
+                        m_currentColumn += output.size();
+                    } else {
+                        std::string output = formatNumber(value.number());
+                        printBuffer += output;
+                        m_currentColumn += output.length();
                     }
-                    m_currentColumn = targetColumn;
+                    break;
                 }
-                // If targetColumn <= m_currentColumn, do nothing (can't move backwards)
-            }
-        } else if (child->type == NODE_STRING_FUNCTION_CALL) {
-            // Handle string function calls like CHR$(65)
-            std::string output = evaluateStringExpression(child);
-            std::cout << output;
-            m_currentColumn += output.length();
-        } else if (child->type == NODE_VARIABLE && child->value.back() == '$') {
-            // Handle string variables like A$, G2$
-            std::string output = variables.getStringVariable(child->value);
-            std::cout << output;
-            m_currentColumn += output.length();
-        } else if (child->type == NODE_ARRAY_ACCESS && child->children.size() >= 1 && child->children[0]->value.back() == '$') {
-            // Handle string arrays like A$(1)
-            std::string output = evaluateStringExpression(child);
-            std::cout << output;
-            m_currentColumn += output.length();
-        } else {
-            std::string output = formatNumber(evaluateExpression(child));
-            std::cout << output;
-            m_currentColumn += output.length();
+            }
         }
+    } catch (const std::exception&) {
+        // What was printed before the error still appears
+        out->write(printBuffer.data(), printBuffer.size());
+        throw;
     }
     
-    // If a print statement has no content (only TABs, commas, semicolons),
-    // it should not print a newline unless it's an empty PRINT statement.
-    if (!hasContent && !stmt->children.empty()) {
-        newlineAtEnd = false;
-    }
-
-    if (newlineAtEnd) {
-        std::cout << std::endl;
+    if (plan->newline) {
+        printBuffer += '\n';
         m_currentColumn = 0;
     }
+    out->write(printBuffer.data(), printBuffer.size());
 }
 
 void AltairBasicInterpreter::executeInput(std::shared_ptr<ASTNode> stmt) {
-    size_t startIndex = 0;
-    
     // Check for prompt string
     if (!stmt->children.empty() && stmt->children[0]->type == NODE_STRING) {
         std::string promptValue = stmt->children[0]->value;
@@ -278,96 +449,98 @@ void AltairBasicInterpreter::executeInput(std::shared_ptr<ASTNode> stmt) {
         bool hasComma = promptValue.back() == ',';
         
         if (hasSemicolon) {
-            std::cout << promptValue.substr(0, promptValue.length() - 1) << "? ";
+            *out << promptValue.substr(0, promptValue.length() - 1) << "? ";
         } else if (hasComma) {
-            std::cout << promptValue.substr(0, promptValue.length() - 1) << "?";
+            *out << promptValue.substr(0, promptValue.length() - 1) << "?";
         } else {
-            std::cout << promptValue << "?";
+            *out << promptValue << "?";
         }
-        startIndex = 1;
     } else {
-        std::cout << "? ";
+        *out << "? ";
     }
     
-    // Get variable list
-    if (startIndex >= stmt->children.size()) {
-        // INPUT statement with no variables, just consume a line of input
-        std::string dummy;
-        std::getline(std::cin, dummy);
-        return;
+    if (nonBlockingInput) {
+        if (inputClosed) {
+            return; // End of input stream
+        }
+        // Hand control back to the host; processLine() completes the INPUT
+        pendingInput = stmt;
+        pendingValues.clear();
+        throw InputSuspended();
     }
-
-    auto varList = stmt->children[startIndex];
-    std::vector<std::string> allValues;
-
+    
+    std::vector<std::string> values;
     while (true) {
-        allValues.clear();
         std::string currentInputLine;
-
-        while(allValues.size() < varList->children.size()) {
 #ifdef __EMSCRIPTEN__
-            std::string current_output = output_buffer.str();
-            if (!current_output.empty()) {
-                flush_output_to_js(current_output.c_str());
-                output_buffer.str("");
-                output_buffer.clear();
-            }
-            await_input_from_js();
-            currentInputLine = get_input_buffer();
+        std::string current_output = output_buffer.str();
+        if (!current_output.empty()) {
+            flush_output_to_js(current_output.c_str());
+            output_buffer.str("");
+            output_buffer.clear();
+        }
+        await_input_from_js();
+        currentInputLine = get_input_buffer();
 #else
-            if (!std::getline(std::cin, currentInputLine)) {
-                return; // End of input stream
-            }
+        if (!readInputLine(currentInputLine)) {
+            return; // End of input stream
+        }
 #endif
+        if (acceptInputLine(stmt, currentInputLine, values)) {
+            break;
+        }
+    }
+}
 
-            std::stringstream ss(currentInputLine);
-            std::string value;
-            while (std::getline(ss, value, ',')) {
-                size_t start = value.find_first_not_of(" \t");
-                size_t end = value.find_last_not_of(" \t");
-                if (start != std::string::npos) {
-                    allValues.push_back(value.substr(start, end - start + 1));
-                } else {
-                    allValues.push_back("");
-                }
-            }
-            if (allValues.size() < varList->children.size()) {
-                std::cout << "?? ";
-            }
+bool AltairBasicInterpreter::acceptInputLine(std::shared_ptr<ASTNode> stmt, const std::string& line, std::vector<std::string>& values) {
+    // INPUT with no variables just consumes a line of input
+    auto varList = stmt->children.empty() ? nullptr : stmt->children.back();
+    if (!varList || varList->type == NODE_STRING) {
+        return true;
+    }
+    
+    std::stringstream ss(line);
+    std::string value;
+    while (std::getline(ss, value, ',')) {
+        size_t start = value.find_first_not_of(" \t");
+        size_t end = value.find_last_not_of(" \t");
+        if (start != std::string::npos) {
+            values.push_back(value.substr(start, end - start + 1));
+        } else {
+            values.push_back("");
         }
+    }
+    if (values.size() < varList->children.size()) {
+        *out << "?? ";
+        return false;
+    }
 
-        bool success = true;
-        for (size_t i = 0; i < varList->children.size(); ++i) {
-            auto var = varList->children[i];
-            if (var->value.back() == '$') {
-                // String variable, no validation needed
-            } else {
-                // Numeric variable, check if it's a valid number
-                try {
-                    std::stod(allValues[i]);
-                } catch (const std::exception&) {
-                    success = false;
-                    break;
-                }
+    for (size_t i = 0; i < varList->children.size(); ++i) {
+        auto var = varList->children[i];
+        if (var->value.back() != '$') {
+            // Numeric variable, check if it's a valid number
+            try {
+                std::stod(values[i]);
+            } catch (const std::exception&) {
+                *out << "REDO FROM START" << std::endl;
+                *out << "? ";
+                values.clear();
+                return false;
             }
         }
+    }
 
-        if (success) {
-            // All inputs are valid, now assign them
-            for (size_t i = 0; i < varList->children.size(); ++i) {
-                auto var = varList->children[i];
-                if (var->value.back() == '$') {
-                    variables.setStringVariable(var->value, allValues[i]);
-                } else {
-                    variables.setNumericVariable(var->value, std::stod(allValues[i]));
-                }
-            }
-            break; // Exit the while(true) loop
+    // All inputs are valid, now assign them
+    for (size_t i = 0; i < varList->children.size(); ++i) {
+        auto var = varList->children[i];
+        if (var->value.back() == '$') {
+            variables.setStringVariable(var->value, values[i]);
         } else {
-            std::cout << "REDO FROM START" << std::endl;
-            std::cout << "? ";
+            variables.setNumericVariable(var->value, narrow(std::stod(values[i])));
         }
     }
+    checkMemory();
+    return true;
 }
 
 void AltairBasicInterpreter::executeLet(std::shared_ptr<ASTNode> stmt) {
@@ -379,52 +552,35 @@ void AltairBasicInterpreter::executeLet(std::shared_ptr<ASTNode> stmt) {
         auto expr = assignment->children[1];
         
         // Check if this is a string variable assignment
-        if (var->type == NODE_VARIABLE && var->value.back() == '$') {
+        if (var->type == NODE_VARIABLE && var->value.back() == '$' && isSelfAppend(var->value, expr)) {
+            // A$ = A$ + X$ grows A$ in place instead of copying it every time
+            if (var->slot < 0) {
+                throw std::runtime_error("ILLEGAL VARIABLE NAME");
+            }
+            Value suffix = evaluateAppendedSuffix(expr);
+            DEBUG_PRINT("  LET " << var->value << " += \"" << suffix.text() << "\"");
+            variables.append(variables.scalar(var->slot), suffix.text());
+            checkMemory();
+        } else if (var->type == NODE_VARIABLE && var->value.back() == '$') {
             // String variable assignment: G2$ = "SHIELD CONTROL"
-            std::string stringValue = evaluateStringExpression(expr);
-            DEBUG_PRINT("  LET " << var->value << " = "" << stringValue << """);
+            Value stringValue = evaluateStringExpression(expr);
+            DEBUG_PRINT("  LET " << var->value << " = \"" << stringValue.text() << "\"");
             variables.setStringVariable(var->value, stringValue);
+            checkMemory();
         } else if (var->type == NODE_ARRAY_ACCESS && var->children.size() >= 2) {
             // Array assignment: check if it's a string array
             auto arrayName = var->children[0];
             if (arrayName->value.back() == '$') {
                 // String array assignment: A$(S) = MID$(L$,Q(S),1)
-                std::string stringValue = evaluateStringExpression(expr);
-                
-                if (var->children.size() == 2) {
-                    // Single dimension: A$(5) = "hello"
-                    auto indexExpr = var->children[1];
-                    int index = static_cast<int>(evaluateExpression(indexExpr));
-                    DEBUG_PRINT("  LET " << arrayName->value << "(" << index << ") = "" << stringValue << """);
-                    variables.setStringArrayElement(arrayName->value, index, stringValue);
-                } else {
-                    // Multi-dimensional: A$(1,2) = "hello"
-                    std::vector<int> indices;
-                    for (size_t i = 1; i < var->children.size(); i++) {
-                        int index = static_cast<int>(evaluateExpression(var->children[i]));
-                        indices.push_back(index);
-                    }
-                    variables.setStringArrayElement(arrayName->value, indices, stringValue);
-                }
+                Value stringValue = evaluateStringExpression(expr);
+                DEBUG_PRINT("  LET " << arrayName->value << "(...) = \"" << stringValue.text() << "\"");
+                variables.assign(element(var), stringValue);
+                checkMemory();
             } else {
-                // Numeric array assignment
+                // Numeric array assignment: A(5) = 10, A(1,2) = 10
                 double value = evaluateExpression(expr);
-                
-                if (var->children.size() == 2) {
-                    // Single dimension: A(5) = 10
-                    auto indexExpr = var->children[1];
-                    int index = static_cast<int>(evaluateExpression(indexExpr));
-                    DEBUG_PRINT("  LET " << arrayName->value << "(" << index << ") = " << value);
-                    variables.setArrayElement(arrayName->value, index, value);
-                } else {
-                    // Multi-dimensional: A(1,2) = 10
-                    std::vector<int> indices;
-                    for (size_t i = 1; i < var->children.size(); i++) {
-                        int index = static_cast<int>(evaluateExpression(var->children[i]));
-                        indices.push_back(index);
-                    }
-                    variables.setArrayElement(arrayName->value, indices, value);
-                }
+                DEBUG_PRINT("  LET " << arrayName->value << "(...) = " << value);
+                element(var) = Value(value);
             }
         } else {
             // Numeric variable assignment
@@ -433,43 +589,58 @@ void AltairBasicInterpreter::executeLet(std::shared_ptr<ASTNode> stmt) {
             if (var->type == NODE_ARRAY_ACCESS) {
                 // This case should be handled above, but keeping for safety
                 if (var->children.size() >= 2) {
-                    auto arrayName = var->children[0];
-                    
-                    if (var->children.size() == 2) {
-                        // Single dimension: A(5) = 10
-                        auto indexExpr = var->children[1];
-                        int index = static_cast<int>(evaluateExpression(indexExpr));
-                        DEBUG_PRINT("  LET " << arrayName->value << "(" << index << ") = " << value);
-                        variables.setArrayElement(arrayName->value, index, value);
-                    } else {
-                        // Multi-dimensional: A(1,2) = 10
-                        std::vector<int> indices;
-                        for (size_t i = 1; i < var->children.size(); i++) {
-                            int index = static_cast<int>(evaluateExpression(var->children[i]));
-                            indices.push_back(index);
-                        }
-                        variables.setArrayElement(arrayName->value, indices, value);
-                    }
+                    element(var) = Value(value);
                 }
             } else {
                 // Regular variable assignment: A = 10
                 DEBUG_PRINT("  LET " << var->value << " = " << value);
-                variables.setNumericVariable(var->value, value);
+                if (var->slot < 0) {
+                    throw std::runtime_error("ILLEGAL VARIABLE NAME");
+                }
+                variables.scalar(var->slot) = Value(value);
             }
         }
     }
+    // This method is called during execution but does nothing
+}
+
+// True for a chain of string + operators whose leftmost operand is the variable itself
+bool AltairBasicInterpreter::isSelfAppend(const std::string& name, std::shared_ptr<ASTNode> expr) {
+    if (expr->type != NODE_BINARY_OP || expr->operator_type != OP_PLUS) {
+        return false;
+    }
+    ASTNode* operand = expr.get();
+    while (operand->type == NODE_BINARY_OP && operand->operator_type == OP_PLUS) {
+        operand = operand->children[0].get();
+    }
+    return operand->type == NODE_VARIABLE && operand->value == name;
+}
+
+// Everything after the leftmost operand of a self-append chain, evaluated left
+// to right before the variable is modified
+Value AltairBasicInterpreter::evaluateAppendedSuffix(std::shared_ptr<ASTNode> expr) {
+    auto left = expr->children[0];
+    Value right = evaluateStringExpression(expr->children[1]);
+    if (left->type != NODE_BINARY_OP) {
+        return right;
+    }
+    Value prefix = evaluateAppendedSuffix(left);
+    return Value::concat(prefix.text(), right.text());
 }
 
 void AltairBasicInterpreter::executeIf(std::shared_ptr<ASTNode> stmt) {
     if (stmt->children.size() < 2) return;
     
-    auto condition = stmt->children[0];
-    double conditionValue = evaluateExpression(condition);
-    
-    if (conditionValue != 0.0) { // Non-zero is true in BASIC
+    if (isTrue(stmt->children[0])) {
         // Execute all statements in the consequent (starting from index 1)
         for (size_t i = 1; i < stmt->children.size(); i++) {
-            executeStatement(stmt->children[i]);
+            try {
+                executeStatement(stmt->children[i]);
+            } catch (const InputSuspended&) {
+                // The rest of the consequent runs once the INPUT is completed
+                pendingStatements.insert(pendingStatements.end(), stmt->children.begin() + i + 1, stmt->children.end());
+                throw;
+            }
         }
     }
 }
@@ -477,16 +648,26 @@ void AltairBasicInterpreter::executeIf(std::shared_ptr<ASTNode> stmt) {
 void AltairBasicInterpreter::executeGoto(std::shared_ptr<ASTNode> stmt) {
     if (stmt->children.empty()) return;
     
-    auto lineNumNode = stmt->children[0];
-    int lineNumber = static_cast<int>(evaluateExpression(lineNumNode));
-    
-    DEBUG_PRINT("GOTO " << lineNumber);
+    if (jumpsActive && stmt->jumpLine >= 0) {
+        // The target exists and JumpAnalysis knows whether any loop is left
+        DEBUG_PRINT("GOTO " << stmt->jumpLine);
+        if (stmt->jumpCrossesNext) {
+            cleanupForLoopStackOnGoto(currentLine, stmt->jumpLine);
+        }
+        currentLine = stmt->jumpLine;
+        currentStatementIndex = 0;
+    } else {
+        auto lineNumNode = stmt->children[0];
+        int lineNumber = static_cast<int>(evaluateExpression(lineNumNode));
+        
+        DEBUG_PRINT("GOTO " << lineNumber);
 
-    // Clean up FOR loop stack when jumping out of loops
-    // Check if GOTO jumps over any NEXT statements, indicating those loops are exited
-    cleanupForLoopStackOnGoto(currentLine, lineNumber);
-    
-    gotoLine(lineNumber);
+        // Clean up FOR loop stack when jumping out of loops
+        // Check if GOTO jumps over any NEXT statements, indicating those loops are exited
+        cleanupForLoopStackOnGoto(currentLine, lineNumber);
+        
+        gotoLine(lineNumber);
+    }
     
     // If we're not already running a program (i.e., direct mode), start execution
     if (!running) {
@@ -497,13 +678,13 @@ void AltairBasicInterpreter::executeGoto(std::shared_ptr<ASTNode> stmt) {
 void AltairBasicInterpreter::executeGosub(std::shared_ptr<ASTNode> stmt) {
     if (stmt->children.empty()) return;
     
-    auto lineNumNode = stmt->children[0];
-    int lineNumber = static_cast<int>(evaluateExpression(lineNumNode));
+    int lineNumber = jumpsActive && stmt->jumpLine >= 0 ? stmt->jumpLine : static_cast<int>(evaluateExpression(stmt->children[0]));
     
     DEBUG_PRINT("GOSUB from line " << currentLine << " stmt " << currentStatementIndex 
               << " to line " << lineNumber << ", callStack size: " << callStack.size() << ", forLoopStack size: " << forLoopStack.size());
     
     // Push call frame with return position AFTER this GOSUB statement
+    checkMemory(sizeof(CallFrame));
     callStack.push(CallFrame(currentLine, currentStatementIndex + 1));
     DEBUG_PRINT("  After GOSUB push, callStack size: " << callStack.size() << ", forLoopStack size: " << forLoopStack.size());
     
@@ -584,7 +765,14 @@ void AltairBasicInterpreter::executeFor(std::shared_ptr<ASTNode> stmt) {
     DEBUG_PRINT("FOR " << var->value << " = " << startValue 
               << " TO " << endValue << " STEP " << stepValue);
     
-    variables.setNumericVariable(var->value, startValue);
+    int slot = var->slot;
+    if (slot < 0) {
+        throw std::runtime_error("ILLEGAL VARIABLE NAME");
+    }
+    if (VariableManager::isStringSlot(slot)) {
+        throw std::runtime_error("TYPE MISMATCH");
+    }
+    variables.scalar(slot) = Value(startValue);
     
     // Check if loop should execute at all (authentic Altair BASIC behavior)
     bool shouldExecute = false;
@@ -595,27 +783,35 @@ void AltairBasicInterpreter::executeFor(std::shared_ptr<ASTNode> stmt) {
     }
     
     if (shouldExecute) {
-        // Store the FIRST STATEMENT AFTER THE FOR to return to
-        // This should be the PRINT statement, not back to FOR
-        int returnLine = currentLine;
-        int returnStmtIndex = currentStatementIndex + 1; // Next statement after FOR
+        checkMemory(sizeof(ForLoopState));
         
-        // Check if there are more statements after FOR on same line
+        // Entering the loop invalidates what its body hoisted last time
+        int loopId = hoistingActive ? loopAnalysis->loopFor(stmt.get()) : -1;
+        if (loopId >= 0) {
+            loopActivations[loopId] = ++activationCounter;
+        }
+        
+        // The body starts at the statement after the FOR, or at the start of
+        // the next line if the FOR ends its line. A FOR typed in direct mode
+        // has no line, and its NEXT jumps to the program with gotoLine.
+        int returnLine = currentLine;
+        int returnStmtIndex = currentStatementIndex + 1;
         auto it = program.find(currentLine);
-        if (it != program.end() && returnStmtIndex < static_cast<int>(it->second.ast->children.size())) {
-            // More statements on this line - return to next statement after FOR
-            DEBUG_PRINT("FOR will return to line " << returnLine 
-                      << " stmt " << returnStmtIndex << ", forLoopStack size: " << forLoopStack.size());
-            ForLoopState loopState(var->value, endValue, stepValue, returnLine, returnStmtIndex);
-            forLoopStack.push(loopState);
-            DEBUG_PRINT("  After FOR push, forLoopStack size: " << forLoopStack.size());
-        } else {
-            // No more statements on this line, go to next line
-            int nextLine = getNextLineNumber(currentLine);
-            DEBUG_PRINT("FOR will return to line " << nextLine << ", forLoopStack size: " << forLoopStack.size());
-            ForLoopState loopState(var->value, endValue, stepValue, nextLine);
-            forLoopStack.push(loopState);
-            DEBUG_PRINT("  After FOR push, forLoopStack size: " << forLoopStack.size());
+        if (it == program.end()) {
+            returnLine = getNextLineNumber(currentLine);
+            returnStmtIndex = -1;
+        } else if (returnStmtIndex >= static_cast<int>(it->second.ast->children.size())) {
+            returnLine = getNextLineNumber(currentLine);
+            returnStmtIndex = 0;
+        }
+        DEBUG_PRINT("FOR will return to line " << returnLine 
+                  << " stmt " << returnStmtIndex << ", forLoopStack size: " << forLoopStack.size());
+        forLoopStack.push(ForLoopState(slot, endValue, stepValue, returnLine, returnStmtIndex, loopId));
+        DEBUG_PRINT("  After FOR push, forLoopStack size: " << forLoopStack.size());
+        
+        const ArrayLoop* arrayLoop = arrayLoopsActive ? arrayLoopAnalysis->loopFor(stmt.get()) : nullptr;
+        if (arrayLoop) {
+            runArrayLoop(*arrayLoop, startValue, endValue, stepValue);
         }
     } else {
         // Skip the entire loop by jumping to the line after the matching NEXT
@@ -628,23 +824,19 @@ void AltairBasicInterpreter::executeNext(std::shared_ptr<ASTNode> stmt) {
         throw std::runtime_error("NEXT WITHOUT FOR");
     }
     
-    auto loopState = forLoopStack.top();
+    // The frame stays on the stack and is updated in place
+    ForLoopState& loopState = forLoopStack.top();
     
     // If there's an explicit variable in NEXT, verify it matches
-    if (!stmt->children.empty()) {
-        auto nextVar = stmt->children[0];
-        if (nextVar->value != loopState.variable) {
-            throw std::runtime_error("NEXT WITHOUT FOR");
-        }
+    if (!stmt->children.empty() && stmt->children[0]->slot != loopState.slot) {
+        throw std::runtime_error("NEXT WITHOUT FOR");
     }
     
-    forLoopStack.pop();
-    
-    double currentValue = variables.getNumericVariable(loopState.variable);
-    currentValue += loopState.stepValue;
-    variables.setNumericVariable(loopState.variable, currentValue);
+    Value& counter = variables.scalar(loopState.slot);
+    double currentValue = narrow(counter.number() + loopState.stepValue);
+    counter = Value(currentValue);
     
-    DEBUG_PRINT("NEXT: " << loopState.variable << " = " << currentValue << ", forLoopStack size: " << forLoopStack.size());
+    DEBUG_PRINT("NEXT: " << VariableManager::nameForSlot(loopState.slot) << " = " << currentValue << ", forLoopStack size: " << forLoopStack.size());
 
     bool continueLoop = false;
     if (loopState.stepValue > 0) {
@@ -654,31 +846,28 @@ void AltairBasicInterpreter::executeNext(std::shared_ptr<ASTNode> stmt) {
     }
     
     if (continueLoop) {
-        // Continue the loop - push the state back and jump to loop body
-        forLoopStack.push(loopState);
-        DEBUG_PRINT("  After NEXT push (continue loop), forLoopStack size: " << forLoopStack.size());
-        if (loopState.returnStatementIndex >= 0) {
-            // This case handles loops where the FOR statement has other statements on its line.
-            // The return point is a specific statement index.
-            if (this->currentLine == loopState.returnLine) {
-                // This is a true same-line FOR..NEXT loop.
-                // We are jumping to a statement on the same line.
-                // The executeLine loop will not break, so we must adjust the index
-                // to account for the loop's own increment.
-                currentStatementIndex = loopState.returnStatementIndex - 1;
-            } else {
-                // The FOR and NEXT are on different lines.
-                // We need to jump to the returnLine. This will cause executeLine to break
-                // and the main loop to resume at the new line.
-                currentLine = loopState.returnLine;
-                currentStatementIndex = loopState.returnStatementIndex;
-            }
-        } else {
-            // This case handles loops where FOR is the only statement on its line.
+        if (loopState.returnStatementIndex < 0) {
             gotoLine(loopState.returnLine);
+        } else if (currentLine == loopState.returnLine) {
+            // The body starts on this line. executeLine keeps going and
+            // advances the index past this NEXT, so point just before it.
+            currentStatementIndex = loopState.returnStatementIndex - 1;
+        } else {
+            // executeLine stops because the line changed, and the main loop
+            // resumes at the body's first statement
+            currentLine = loopState.returnLine;
+            currentStatementIndex = loopState.returnStatementIndex;
         }
+        return;
     }
-    // If not continuing loop, just fall through to next statement
+    
+    if (loopState.loopId >= 0 && loopState.loopId < static_cast<int>(loopActivations.size())) {
+        // The body can only be reached again by jumping into it, when the
+        // values it hoisted may be out of date
+        loopActivations[loopState.loopId] = 0;
+    }
+    forLoopStack.pop();
+    // Carry on with the statement after the NEXT
 }
 
 void AltairBasicInterpreter::executeProgram() {
@@ -695,8 +884,35 @@ void AltairBasicInterpreter::executeProgram() {
         currentLine = program.begin()->first;
     }
     
-    collectDataItems();
+    // The DATA table is only rebuilt after the program has been edited, so
+    // RUN and direct-mode GOTO don't rescan an unchanged program
+    if (dataTableStale) {
+        collectDataItems();
+        checkMemory();
+    }
+    dataPointer = 0;
     
+    // DEBUG traces every evaluation, so it turns hoisting off
+    hoistingActive = loopHoisting && !debug;
+    if (hoistingActive) {
+        prepareLoopHoisting();
+    }
+    integersActive = !debug;
+    if (integersActive) {
+        prepareIntegers();
+    }
+    arrayLoopsActive = !debug;
+    if (arrayLoopsActive) {
+        prepareArrayLoops();
+    }
+    jumpsActive = !debug;
+    if (jumpsActive) {
+        prepareJumps();
+    }
+    runProgram(false);
+}
+
+void AltairBasicInterpreter::runProgram(bool resuming) {
     while (running && !stopExecution) {
         DEBUG_PRINT("Program loop: currentLine=" << currentLine << ", currentStatementIndex=" << currentStatementIndex << ", callStack size: " << callStack.size() << ", forLoopStack size: " << forLoopStack.size());
         auto it = program.find(currentLine);
@@ -706,6 +922,16 @@ void AltairBasicInterpreter::executeProgram() {
         
         try {
             int originalLine = currentLine;
+            if (resuming) {
+                // Finish the statement that was suspended in INPUT, then carry on
+                // with the rest of its line unless it jumped somewhere else
+                resuming = false;
+                runPendingStatements();
+                if (currentLine != originalLine) {
+                    continue;
+                }
+                currentStatementIndex++;
+            }
             executeLine(it->second.ast);
 
             // Only move to next line if currentLine wasn't changed by GOTO/GOSUB/NEXT
@@ -718,12 +944,16 @@ void AltairBasicInterpreter::executeProgram() {
                     break;
                 }
             }
+        } catch (const InputSuspended&) {
+            // Stay in the running state; processLine() resumes when input arrives
+            return;
         } catch (const std::exception& e) {
             if (on_error_goto_line != -1) {
-                std::cout << e.what() << std::endl;
+                *out << e.what() << std::endl;
                 stopExecution = true;
                 on_error_goto_line = -1; // Reset error handler
             } else {
+                reportPeakMemory();
                 throw; // Re-throw to be caught by processLine
             }
         }
@@ -731,6 +961,7 @@ void AltairBasicInterpreter::executeProgram() {
     
     DEBUG_PRINT("Program execution finished.");
     running = false;
+    reportPeakMemory();
 }
 
 void AltairBasicInterpreter::executeData(std::shared_ptr<ASTNode> stmt) {
@@ -744,39 +975,48 @@ void AltairBasicInterpreter::executeRead(std::shared_ptr<ASTNode> stmt) {
     auto varList = stmt->children[0];
     
     for (auto var : varList->children) {
-        if (dataPointer >= dataItems.size()) {
-            throw std::runtime_error("OUT OF DATA");
-        }
-        
-        if (var->value.back() == '$') {
-            // String variable - only simple variables supported for now
-            variables.setStringVariable(var->value, dataItems[dataPointer]);
+        Value value = dataValue(var->value.back() == '$');
+        if (var->type == NODE_ARRAY_ACCESS) {
+            variables.assign(element(var), std::move(value));
+        } else if (var->slot >= 0) {
+            variables.assign(variables.scalar(var->slot), std::move(value));
         } else {
-            // Numeric variable
-            try {
-                double value = std::stod(dataItems[dataPointer]);
-                
-                if (var->type == NODE_ARRAY_ACCESS) {
-                    std::vector<int> indices;
-                    for (size_t i = 1; i < var->children.size(); i++) {
-                        int index = static_cast<int>(evaluateExpression(var->children[i]));
-                        indices.push_back(index);
-                    }
-                    variables.setArrayElement(var->value, indices, value);
-                } else {
-                    variables.setNumericVariable(var->value, value);
-                }
-            } catch (const std::exception&) {
-                throw std::runtime_error("SYNTAX ERROR");
-            }
+            throw std::runtime_error("ILLEGAL VARIABLE NAME");
         }
         
         dataPointer++;
     }
 }
 
+// The DATA item the next READ takes, as a string or a number. The caller
+// advances dataPointer once the value is stored.
+Value AltairBasicInterpreter::dataValue(bool isString) {
+    if (dataPointer >= dataItems.size()) {
+        throw std::runtime_error("OUT OF DATA");
+    }
+    
+    const DataItem& item = dataItems[dataPointer];
+    if (isString) {
+        return item.text;
+    } else if (item.isNumeric) {
+        return Value(narrow(item.number));
+    }
+    throw std::runtime_error("SYNTAX ERROR");
+}
+
 void AltairBasicInterpreter::executeRestore(std::shared_ptr<ASTNode> stmt) {
-    dataPointer = 0;
+    if (stmt->children.empty()) {
+        dataPointer = 0;
+        return;
+    }
+    
+    // RESTORE n: the next READ takes the first item on or after line n
+    int lineNumber = static_cast<int>(evaluateExpression(stmt->children[0]));
+    auto offset = dataLineOffsets.find(lineNumber);
+    if (offset == dataLineOffsets.end()) {
+        throw std::runtime_error("UNDEFINED LINE NUMBER");
+    }
+    dataPointer = offset->second;
 }
 
 void AltairBasicInterpreter::executeEnd(std::shared_ptr<ASTNode> stmt) {
@@ -784,7 +1024,7 @@ void AltairBasicInterpreter::executeEnd(std::shared_ptr<ASTNode> stmt) {
 }
 
 void AltairBasicInterpreter::executeStop(std::shared_ptr<ASTNode> stmt) {
-    std::cout << "BREAK IN " << currentLine << std::endl;
+    *out << "BREAK IN " << currentLine << std::endl;
     stopExecution = true;
 }
 
@@ -805,6 +1045,7 @@ void AltairBasicInterpreter::executeOn(std::shared_ptr<ASTNode> stmt) {
     if (action->keyword == KW_GOTO) {
         gotoLine(lineNumber);
     } else if (action->keyword == KW_GOSUB) {
+        checkMemory(sizeof(CallFrame));
         callStack.push(CallFrame(currentLine, currentStatementIndex));
         gotoLine(lineNumber);
     }
@@ -812,20 +1053,23 @@ void AltairBasicInterpreter::executeOn(std::shared_ptr<ASTNode> stmt) {
 
 void AltairBasicInterpreter::executeList() {
     for (const auto& pair : program) {
-        std::cout << pair.first << " ";
+        *out << pair.first << " ";
         // Reconstruct the original line text
         auto line = pair.second.ast;
         for (auto stmt : line->children) {
             printStatement(stmt);
         }
-        std::cout << std::endl;
+        *out << std::endl;
     }
 }
 
 void AltairBasicInterpreter::executeNew() {
     program.clear();
+    programBytes = 0;
     variables.clearAll();
     dataItems.clear();
+    dataLineOffsets.clear();
+    programChanged();
     dataPointer = 0;
     currentLine = -1;
     
@@ -852,6 +1096,7 @@ void AltairBasicInterpreter::executeRun() {
     }
     
     currentLine = -1; // Always start RUN from the beginning
+    currentStatementIndex = 0;
     executeProgram();
 }
 
@@ -868,6 +1113,7 @@ void AltairBasicInterpreter::executeDim(std::shared_ptr<ASTNode> stmt) {
                 // Single dimension: DIM A(10)
                 auto sizeExpr = dimDecl->children[1];
                 int size = static_cast<int>(evaluateExpression(sizeExpr));
+                checkMemory(VariableManager::arrayBytesFor({size}));
                 variables.dimArray(arrayName->value, size);
             } else {
                 // Multi-dimensional: DIM A(10,20,5)
@@ -876,91 +1122,465 @@ void AltairBasicInterpreter::executeDim(std::shared_ptr<ASTNode> stmt) {
                     int size = static_cast<int>(evaluateExpression(dimDecl->children[i]));
                     dimensions.push_back(size);
                 }
+                checkMemory(VariableManager::arrayBytesFor(dimensions));
                 variables.dimArray(arrayName->value, dimensions);
             }
         }
     }
 }
 
+// Row-major offset of the element named by an array access node, whose
+// children after the first are the subscripts. 1-, 2- and 3-D accesses are
+// unrolled; a single subscript indexes the storage flat whatever the rank.
+size_t AltairBasicInterpreter::arrayOffset(const ArrayShape& shape, const ASTNode& access) {
+    const auto& subscripts = access.children;
+    size_t count = subscripts.size() - 1;
+    
+    if (count == 1) {
+        int i = subscript(subscripts[1]);
+        if (i < 0 || i >= shape.size) {
+            throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+        }
+        return i;
+    }
+    if (count != shape.extents.size()) {
+        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+    }
+    
+    const int* extents = shape.extents.data();
+    const int* strides = shape.strides.data();
+    if (count == 2) {
+        int i = subscript(subscripts[1]);
+        int j = subscript(subscripts[2]);
+        if (i < 0 || i >= extents[0] || j < 0 || j >= extents[1]) {
+            throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+        }
+        return i * strides[0] + j;
+    }
+    if (count == 3) {
+        int i = subscript(subscripts[1]);
+        int j = subscript(subscripts[2]);
+        int k = subscript(subscripts[3]);
+        if (i < 0 || i >= extents[0] || j < 0 || j >= extents[1] || k < 0 || k >= extents[2]) {
+            throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+        }
+        return i * strides[0] + j * strides[1] + k;
+    }
+    
+    size_t offset = 0;
+    for (size_t d = 0; d < count; d++) {
+        int index = subscript(subscripts[d + 1]);
+        if (index < 0 || index >= extents[d]) {
+            throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+        }
+        offset += static_cast<size_t>(index) * strides[d];
+    }
+    return offset;
+}
+
+// Subscripts are truncated to int. Integer expressions and plain variables
+// skip the floating-point evaluator.
+int AltairBasicInterpreter::subscript(const std::shared_ptr<ASTNode>& expr) {
+    int64_t value;
+    if (integersActive && expr->hoistSlot < 0 && integerValue(*expr, value) &&
+        value >= INT_MIN && value <= INT_MAX) {
+        return static_cast<int>(value);
+    }
+    return static_cast<int>(evaluateExpression(expr));
+}
+
+// Only single-subscript accesses auto-dimension an undeclared array
+Value& AltairBasicInterpreter::element(const std::shared_ptr<ASTNode>& access) {
+    ValueArray* array = variables.getArray(access->children[0]->slot, access->children.size() == 2);
+    if (!array) {
+        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+    }
+    int offset = static_cast<int>(arrayOffset(array->shape, *access));
+    if (VariableManager::pageMissing(*array, offset)) {
+        checkMemory(VariableManager::PAGE_BYTES);
+    }
+    return variables.writeElement(*array, offset);
+}
+
+// Reading never allocates: unwritten parts of a paged array read as 0 or ""
+const Value& AltairBasicInterpreter::readElement(const std::shared_ptr<ASTNode>& access) {
+    ValueArray* array = variables.getArray(access->children[0]->slot, access->children.size() == 2);
+    if (!array) {
+        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+    }
+    return array->read(static_cast<int>(arrayOffset(array->shape, *access)));
+}
+
+// Copies a DEF FN body, turning references to the parameter into NODE_PARAMETER.
+// Leaves other than the parameter are shared with the program.
+static std::shared_ptr<ASTNode> compileFunctionBody(const std::shared_ptr<ASTNode>& node, int parameterSlot) {
+    if (node->type == NODE_VARIABLE && node->slot == parameterSlot) {
+        return std::make_shared<ASTNode>(NODE_PARAMETER, node->value);
+    }
+    if (node->children.empty()) {
+        return node;
+    }
+    
+    auto copy = std::make_shared<ASTNode>(*node);
+    copy->hoistSlot = -1;
+    copy->integral = false;
+    // The name of an array access is not a read of the variable
+    for (size_t i = node->type == NODE_ARRAY_ACCESS ? 1 : 0; i < copy->children.size(); i++) {
+        copy->children[i] = compileFunctionBody(copy->children[i], parameterSlot);
+    }
+    return copy;
+}
+
 void AltairBasicInterpreter::executeDef(std::shared_ptr<ASTNode> stmt) {
     if (stmt->children.size() != 3) {
         throw std::runtime_error("SYNTAX ERROR");
     }
     
-    std::string funcName = stmt->children[0]->value;
-    std::string parameter = stmt->children[1]->value;
-    auto body = stmt->children[2];
+    int slot = VariableManager::functionSlotFor(stmt->children[0]->value);
+    int parameterSlot = stmt->children[1]->slot;
+    if (slot < 0 || parameterSlot < 0 || VariableManager::isStringSlot(parameterSlot)) {
+        throw std::runtime_error("SYNTAX ERROR");
+    }
     
-    userDefinedFunctions[funcName] = UserDefinedFunction(funcName, parameter, body);
+    // Running the same DEF again keeps its compiled body; a different DEF of
+    // the same name replaces it at every call site
+    UserDefinedFunction& function = userFunctions[slot];
+    if (function.definition != stmt) {
+        function.body = compileFunctionBody(stmt->children[2], parameterSlot);
+        function.definition = stmt;
+    }
 }
 
-double AltairBasicInterpreter::evaluateExpression(std::shared_ptr<ASTNode> expr) {
-    DEBUG_PRINT("Evaluating expression of type: " << expr->type);
-    switch (expr->type) {
-        case NODE_NUMBER: {
-            DEBUG_PRINT("  NODE_NUMBER: " << expr->value);
-            return std::stod(expr->value);
+Value AltairBasicInterpreter::callUserFunction(const ASTNode& call) {
+    auto body = userFunctions[call.slot].body;
+    if (!body) {
+        throw std::runtime_error("UNDEFINED USER FUNCTION");
+    }
+    if (call.children.size() != 2) {
+        throw std::runtime_error("SYNTAX ERROR");
+    }
+    
+    double argument = evaluateExpression(call.children[1]);
+    DEBUG_PRINT("Calling user-defined function: " << call.value << " with " << argument);
+    
+    // Calls nest, so the enclosing call's argument is put back afterwards
+    double enclosing = functionArgument;
+    functionArgument = argument;
+    double result = evaluateExpression(body);
+    functionArgument = enclosing;
+    return Value(result);
+}
+
+void AltairBasicInterpreter::executeRandomize(std::shared_ptr<ASTNode> stmt) {
+    if (stmt->children.empty()) {
+        rng.seedFromDevice();
+    } else {
+        rng.seedFromNumber(evaluateExpression(stmt->children[0]));
+    }
+}
+
+// MAT statements work on whole arrays. Row and column 0 are not part of the
+// matrix: DIM A(M, N) holds an M by N matrix in A(1, 1) to A(M, N), and DIM
+// V(N) a vector in V(1) to V(N). Operands are copied out as Matrix, the
+// kernel runs on plain doubles, and the result is stored into the target,
+// which is redimensioned first if its shape is different.
+void AltairBasicInterpreter::executeMat(std::shared_ptr<ASTNode> stmt) {
+    const std::string& operation = stmt->value;
+    const auto& args = stmt->children;
+    
+    if (operation == "READ") {
+        for (const auto& name : args) {
+            readMatrix(*name);
+        }
+        return;
+    }
+    if (operation == "PRINT") {
+        for (size_t i = 0; i < args.size(); i++) {
+            if (args[i]->type == NODE_VARIABLE) {
+                bool packed = i + 1 < args.size() && args[i + 1]->value == ";";
+                printMatrix(*args[i], packed);
+            }
+        }
+        return;
+    }
+    
+    Matrix result(0, 0);
+    if (operation == "COPY") {
+        result = loadMatrix(*args[1]);
+    } else if (operation == "ADD") {
+        result = matrixSum(loadMatrix(*args[1]), loadMatrix(*args[2]));
+    } else if (operation == "SUB") {
+        result = matrixDifference(loadMatrix(*args[1]), loadMatrix(*args[2]));
+    } else if (operation == "MUL") {
+        Matrix a = loadMatrix(*args[1]);
+        Matrix b = loadMatrix(*args[2]);
+        if (a.cols == b.rows) {
+            checkMemory(VariableManager::arrayBytesFor({a.rows, b.cols}));
+        }
+        result = matrixProduct(a, b);
+    } else if (operation == "SCALE") {
+        double k = evaluateExpression(args[1]);
+        result = matrixScale(k, loadMatrix(*args[2]));
+    } else if (operation == "TRN") {
+        result = matrixTranspose(loadMatrix(*args[1]));
+    } else if (operation == "INV") {
+        result = matrixInverse(loadMatrix(*args[1]));
+    } else {
+        // ZER, CON and IDN take the bounds given, or keep the target's
+        if (args.size() > 1) {
+            std::vector<int> dimensions;
+            for (size_t i = 1; i < args.size(); i++) {
+                dimensions.push_back(static_cast<int>(evaluateExpression(args[i])));
+            }
+            if (operation == "IDN" && dimensions.size() == 1) {
+                dimensions.push_back(dimensions[0]);
+            }
+            if (dimensions.size() > 2) {
+                throw std::runtime_error("DIMENSION MISMATCH");
+            }
+            checkMemory(VariableManager::arrayBytesFor(dimensions));
+            for (int dim : dimensions) {
+                if (dim < 0) {
+                    throw std::runtime_error("ILLEGAL FUNCTION CALL");
+                }
+            }
+            result = Matrix(dimensions[0], dimensions.size() == 2 ? dimensions[1] : 1, dimensions.size() == 1);
+        } else {
+            result = loadMatrix(*args[0]);
+        }
+        
+        if (operation == "IDN") {
+            if (result.vector || result.rows != result.cols) {
+                throw std::runtime_error("DIMENSION MISMATCH");
+            }
+            result = matrixIdentity(result.rows);
+        } else {
+            std::fill(result.data.begin(), result.data.end(), operation == "CON" ? 1.0 : 0.0);
+        }
+    }
+    storeMatrix(*args[0], result);
+}
+
+// Offset of element (i, j), counted from 1, of a one- or two-dimensional array
+static int matrixOffset(const ArrayShape& shape, int i, int j) {
+    return shape.extents.size() == 1 ? i : i * shape.strides[0] + j;
+}
+
+// An array used as a MAT operand. Like an element access with one subscript,
+// an undeclared name is dimensioned as a vector of 10.
+Matrix AltairBasicInterpreter::loadMatrix(const ASTNode& name) {
+    if (VariableManager::isStringSlot(name.slot)) {
+        throw std::runtime_error("TYPE MISMATCH");
+    }
+    const ValueArray& array = *variables.getArray(name.slot, true);
+    const ArrayShape& shape = array.shape;
+    if (shape.extents.size() > 2) {
+        throw std::runtime_error("DIMENSION MISMATCH");
+    }
+    
+    bool vector = shape.extents.size() == 1;
+    Matrix matrix(shape.extents[0] - 1, vector ? 1 : shape.extents[1] - 1, vector);
+    for (int i = 0; i < matrix.rows; i++) {
+        for (int j = 0; j < matrix.cols; j++) {
+            matrix.at(i, j) = array.read(matrixOffset(shape, i + 1, j + 1)).number();
+        }
+    }
+    return matrix;
+}
+
+void AltairBasicInterpreter::storeMatrix(const ASTNode& name, const Matrix& matrix) {
+    if (name.slot < 0) {
+        throw std::runtime_error("ILLEGAL VARIABLE NAME");
+    }
+    if (VariableManager::isStringSlot(name.slot)) {
+        throw std::runtime_error("TYPE MISMATCH");
+    }
+    
+    std::vector<int> dimensions{matrix.rows};
+    if (!matrix.vector) {
+        dimensions.push_back(matrix.cols);
+    }
+    ValueArray* array = variables.getArray(name.slot, false);
+    bool reshape = !array || array->shape.extents.size() != dimensions.size();
+    for (size_t d = 0; !reshape && d < dimensions.size(); d++) {
+        reshape = array->shape.extents[d] != dimensions[d] + 1;
+    }
+    if (reshape) {
+        checkMemory(VariableManager::arrayBytesFor(dimensions));
+        variables.dimArray(name.value, dimensions);
+        array = variables.getArray(name.slot, false);
+    }
+    
+    for (int i = 0; i < matrix.rows; i++) {
+        for (int j = 0; j < matrix.cols; j++) {
+            int offset = matrixOffset(array->shape, i + 1, j + 1);
+            if (VariableManager::pageMissing(*array, offset)) {
+                checkMemory(VariableManager::PAGE_BYTES);
+            }
+            variables.writeElement(*array, offset) = Value(narrow(matrix.at(i, j)));
+        }
+    }
+}
+
+// MAT READ fills elements from 1 in row order, numbers or strings by the
+// array's type
+void AltairBasicInterpreter::readMatrix(const ASTNode& name) {
+    ValueArray& array = *variables.getArray(name.slot, true);
+    const ArrayShape& shape = array.shape;
+    if (shape.extents.size() > 2) {
+        throw std::runtime_error("DIMENSION MISMATCH");
+    }
+    
+    bool isString = VariableManager::isStringSlot(name.slot);
+    int rows = shape.extents[0] - 1;
+    int cols = shape.extents.size() == 1 ? 1 : shape.extents[1] - 1;
+    for (int i = 1; i <= rows; i++) {
+        for (int j = 1; j <= cols; j++) {
+            Value value = dataValue(isString);
+            int offset = matrixOffset(shape, i, j);
+            if (VariableManager::pageMissing(array, offset)) {
+                checkMemory(VariableManager::PAGE_BYTES);
+            }
+            variables.assign(variables.writeElement(array, offset), std::move(value));
+            dataPointer++;
+        }
+    }
+}
+
+// MAT PRINT puts each row of a matrix on a line, and a vector on one line,
+// with a blank line after. Elements are spaced by print zone, or packed like
+// PRINT A; B when the array is followed by a semicolon.
+void AltairBasicInterpreter::printMatrix(const ASTNode& name, bool packed) {
+    const ValueArray& array = *variables.getArray(name.slot, true);
+    const ArrayShape& shape = array.shape;
+    if (shape.extents.size() > 2) {
+        throw std::runtime_error("DIMENSION MISMATCH");
+    }
+    
+    bool vector = shape.extents.size() == 1;
+    int rows = vector ? 1 : shape.extents[0] - 1;
+    int cols = vector ? shape.extents[0] - 1 : shape.extents[1] - 1;
+    printBuffer.clear();
+    for (int i = 1; i <= rows; i++) {
+        for (int j = 1; j <= cols; j++) {
+            if (j > 1 && !packed) {
+                int nextZone = ((m_currentColumn / 14) + 1) * 14;
+                printBuffer.append(nextZone - m_currentColumn, ' ');
+                m_currentColumn = nextZone;
+            }
+            const Value& value = array.read(vector ? j : matrixOffset(shape, i, j));
+            if (value.isString()) {
+                StringView output = value.text();
+                printBuffer.append(output.data(), output.size());
+                m_currentColumn += output.size();
+            } else {
+                std::string output = formatNumber(value.number());
+                printBuffer += output;
+                m_currentColumn += output.length();
+            }
+        }
+        printBuffer += '\n';
+        m_currentColumn = 0;
+    }
+    printBuffer += '\n';
+    out->write(printBuffer.data(), printBuffer.size());
+}
+
+// LEFT$(s, n), RIGHT$(s, n) or MID$(s, start, length), whose result is part of s
+static bool isSubstringCall(const ASTNode& call) {
+    size_t arguments = call.value == "MID$" ? 3 : (call.value == "LEFT$" || call.value == "RIGHT$") ? 2 : 0;
+    if (arguments == 0 || call.children.size() != arguments || !isStringOperand(*call.children[0])) {
+        return false;
+    }
+    for (size_t i = 1; i < arguments; i++) {
+        if (isStringOperand(*call.children[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The only binary operators defined on strings are + and the comparisons
+static Value stringOperation(OperatorType op, StringView left, StringView right) {
+    switch (op) {
+        case OP_PLUS: return Value::concat(left, right);
+        case OP_EQUAL: return Value((left == right) ? -1.0 : 0.0);
+        case OP_NOT_EQUAL: return Value((left != right) ? -1.0 : 0.0);
+        case OP_LESS: return Value((left < right) ? -1.0 : 0.0);
+        case OP_LESS_EQUAL: return Value((left <= right) ? -1.0 : 0.0);
+        case OP_GREATER: return Value((left > right) ? -1.0 : 0.0);
+        case OP_GREATER_EQUAL: return Value((left >= right) ? -1.0 : 0.0);
+        default: throw std::runtime_error("TYPE MISMATCH"); // Cannot do arithmetic on strings
+    }
+}
+
+Value AltairBasicInterpreter::evaluate(std::shared_ptr<ASTNode> expr) {
+    if (expr->hoistSlot >= 0 && hoistingActive) {
+        return hoistedValue(expr);
+    }
+    if (expr->integral && integersActive) {
+        int64_t value;
+        if (integerValue(*expr, value)) {
+            return Value(static_cast<double>(value));
+        }
+    }
+    return evaluateNode(expr);
+}
+
+// The expression evaluator. Numbers and strings share one Value type, so the
+// operators check what their operands turned out to be rather than guessing
+// from the shape of the tree.
+Value AltairBasicInterpreter::evaluateNode(std::shared_ptr<ASTNode> expr) {
+    DEBUG_PRINT("Evaluating expression of type: " << expr->type);
+    switch (expr->type) {
+        case NODE_NUMBER: {
+            DEBUG_PRINT("  NODE_NUMBER: " << expr->value);
+            if (!expr->text.isString()) {
+                return expr->text; // Decoded when the line was entered
+            }
+            return Value(narrow(std::stod(expr->value)));
         }
             
+        case NODE_STRING:
+            return expr->text;
+            
+        case NODE_PARAMETER:
+            return Value(functionArgument);
+            
         case NODE_VARIABLE: {
-            double value = variables.getNumericVariable(expr->value);
+            if (expr->slot < 0) {
+                // A name that can never be assigned always reads as 0 or ""
+                return expr->value.back() == '$' ? Value::emptyString() : Value();
+            }
+            const Value& value = variables.scalar(expr->slot);
             DEBUG_PRINT("  NODE_VARIABLE: " << expr->value << " = " << value);
             return value;
         }
             
         case NODE_BINARY_OP:
             {
-                // Check for string comparison
                 auto left_node = expr->children[0];
                 auto right_node = expr->children[1];
 
-                bool isStringComparison = (left_node->type == NODE_STRING || 
-                                           (left_node->type == NODE_VARIABLE && left_node->value.back() == '$') || 
-                                           left_node->type == NODE_STRING_FUNCTION_CALL ||
-                                           (left_node->type == NODE_ARRAY_ACCESS && left_node->children.size() >= 1 && left_node->children[0]->value.back() == '$') ||
-                                           right_node->type == NODE_STRING || 
-                                           (right_node->type == NODE_VARIABLE && right_node->value.back() == '$') || 
-                                           right_node->type == NODE_STRING_FUNCTION_CALL ||
-                                           (right_node->type == NODE_ARRAY_ACCESS && right_node->children.size() >= 1 && right_node->children[0]->value.back() == '$'));
-
-                if (isStringComparison) {
-                    std::string left_s = evaluateStringExpression(left_node);
-                    std::string right_s = evaluateStringExpression(right_node);
-                    DEBUG_PRINT("  NODE_BINARY_OP (string): "" << left_s << "" " << expr->operator_type << " "" << right_s << """);
-
-                    switch (expr->operator_type) {
-                        case OP_EQUAL: return (left_s == right_s) ? -1.0 : 0.0;
-                        case OP_NOT_EQUAL: return (left_s != right_s) ? -1.0 : 0.0;
-                        case OP_LESS: return (left_s < right_s) ? -1.0 : 0.0;
-                        case OP_LESS_EQUAL: return (left_s <= right_s) ? -1.0 : 0.0;
-                        case OP_GREATER: return (left_s > right_s) ? -1.0 : 0.0;
-                        case OP_GREATER_EQUAL: return (left_s >= right_s) ? -1.0 : 0.0;
-                        default: throw std::runtime_error("TYPE MISMATCH"); // Cannot do arithmetic on strings
-                    }
+                if (isStringOperand(*left_node) || isStringOperand(*right_node)) {
+                    // Compare or concatenate without copying either operand
+                    Value leftScratch, rightScratch;
+                    StringView left_s = evaluateStringView(left_node, leftScratch);
+                    StringView right_s = evaluateStringView(right_node, rightScratch);
+                    DEBUG_PRINT("  NODE_BINARY_OP (string): \"" << left_s << "\" " << expr->operator_type << " \"" << right_s << "\"");
+                    return stringOperation(expr->operator_type, left_s, right_s);
                 }
 
-                double left = evaluateExpression(expr->children[0]);
-                double right = evaluateExpression(expr->children[1]);
-                DEBUG_PRINT("  NODE_BINARY_OP: " << left << " " << expr->operator_type << " " << right);
-                
-                switch (expr->operator_type) {
-                    case OP_PLUS: return left + right;
-                    case OP_MINUS: return left - right;
-                    case OP_MULTIPLY: return left * right;
-                    case OP_DIVIDE:
-                        if (right == 0.0) throw std::runtime_error("DIVISION BY ZERO");
-                        return left / right;
-                    case OP_POWER: return std::pow(left, right);
-                    case OP_EQUAL: return (left == right) ? -1.0 : 0.0;
-                    case OP_NOT_EQUAL: return (left != right) ? -1.0 : 0.0;
-                    case OP_LESS: return (left < right) ? -1.0 : 0.0;
-                    case OP_LESS_EQUAL: return (left <= right) ? -1.0 : 0.0;
-                    case OP_GREATER: return (left > right) ? -1.0 : 0.0;
-                    case OP_GREATER_EQUAL: return (left >= right) ? -1.0 : 0.0;
-                    case OP_AND: return (left != 0.0 && right != 0.0) ? -1.0 : 0.0;
-                    case OP_OR: return (left != 0.0 || right != 0.0) ? -1.0 : 0.0;
-                    default: throw std::runtime_error("SYNTAX ERROR");
+                Value left = evaluate(left_node);
+                Value right = evaluate(right_node);
+                if (left.isString() || right.isString()) {
+                    if (!left.isString() || !right.isString()) {
+                        throw std::runtime_error("TYPE MISMATCH");
+                    }
+                    return stringOperation(expr->operator_type, left.text(), right.text());
                 }
+                DEBUG_PRINT("  NODE_BINARY_OP: " << left.number() << " " << expr->operator_type << " " << right.number());
+                return Value(narrow(MathFunctions::operate(expr->operator_type, left.number(), right.number())));
             }
             
         case NODE_UNARY_OP:
@@ -968,9 +1588,9 @@ double AltairBasicInterpreter::evaluateExpression(std::shared_ptr<ASTNode> expr)
                 double operand = evaluateExpression(expr->children[0]);
                 DEBUG_PRINT("  NODE_UNARY_OP: " << expr->value << " " << operand);
                 if (expr->operator_type == OP_MINUS) {
-                    return -operand;
+                    return Value(-operand);
                 } else if (expr->value == "NOT") {
-                    return (operand == 0.0) ? -1.0 : 0.0;
+                    return Value((operand == 0.0) ? -1.0 : 0.0);
                 }
                 throw std::runtime_error("SYNTAX ERROR");
             }
@@ -988,66 +1608,73 @@ double AltairBasicInterpreter::evaluateExpression(std::shared_ptr<ASTNode> expr)
                         throw std::runtime_error("SYNTAX ERROR");
                     }
                     
-                    std::string strArg;
+                    Value scratch;
+                    StringView strArg;
                     auto arg = expr->children[0];
                     
-                    if (arg->type == NODE_STRING) {
-                        strArg = arg->value;
-                    } else if (arg->type == NODE_VARIABLE && arg->value.back() == '$') {
-                        strArg = variables.getStringVariable(arg->value);
-                    } else if (arg->type == NODE_STRING_FUNCTION_CALL) {
-                        strArg = evaluateStringExpression(arg);
+                    if (arg->type == NODE_STRING ||
+                        (arg->type == NODE_VARIABLE && arg->value.back() == '$') ||
+                        arg->type == NODE_STRING_FUNCTION_CALL) {
+                        strArg = evaluateStringView(arg, scratch);
                     } else {
                         throw std::runtime_error("TYPE MISMATCH");
                     }
                     
                     if (upperName == "LEN") {
-                        return MathFunctions::len(strArg);
+                        return Value(MathFunctions::len(strArg));
                     } else if (upperName == "ASC") {
-                        return MathFunctions::asc(strArg);
+                        return Value(MathFunctions::asc(strArg));
                     } else if (upperName == "VAL") {
-                        return MathFunctions::val(strArg);
+                        return Value(narrow(MathFunctions::val(strArg)));
                     }
                 }
                 
-                // Check for user-defined functions first
-                if (userDefinedFunctions.find(expr->value) != userDefinedFunctions.end()) {
+                if (upperName == "FRE") {
+                    // FRE(0) and FRE("") both report the bytes left under the session limit
                     if (expr->children.size() != 1) {
                         throw std::runtime_error("SYNTAX ERROR");
                     }
-                    
-                    DEBUG_PRINT("Calling user-defined function: " << expr->value);
-                    
-                    auto& func = userDefinedFunctions[expr->value];
-                    double argValue = evaluateExpression(expr->children[0]);
-                    
-                    DEBUG_PRINT("Setting parameter " << func.parameter << " = " << argValue);
-                    
-                    // Set parameter value
-                    variables.setNumericVariable(func.parameter, argValue);
-                    
-                    // Evaluate function body
-                    double result = evaluateExpression(func.body);
-                    
-                    return result;
+                    evaluate(expr->children[0]);
+                    return Value(narrow(static_cast<double>(memoryLimit - std::min(memoryLimit, memoryUsed()))));
+                }
+                
+                if (upperName == "RND") {
+                    if (expr->children.empty()) {
+                        return Value(narrow(rng.next()));
+                    } else if (expr->children.size() == 1) {
+                        return Value(narrow(rng.rnd(evaluateExpression(expr->children[0]))));
+                    }
+                    throw std::runtime_error("SYNTAX ERROR");
                 }
                 
                 std::vector<double> args;
                 for (auto arg : expr->children) {
                     args.push_back(evaluateExpression(arg));
                 }
-                return MathFunctions::callFunction(expr->value, args);
+                return Value(narrow(MathFunctions::callFunction(expr->value, args)));
             }
             
         case NODE_STRING_FUNCTION_CALL:
             {
-                // String functions can't be used in numeric context
-                throw std::runtime_error("TYPE MISMATCH");
-            }
-        case NODE_STRING:
-            {
-                // Strings can't be used in numeric context
-                throw std::runtime_error("TYPE MISMATCH");
+                if (isSubstringCall(*expr)) {
+                    Value scratch;
+                    return Value::string(evaluateStringView(expr, scratch));
+                }
+                
+                // Arguments are sorted by what they evaluate to, so string
+                // array elements and concatenations can be passed as well
+                std::vector<double> numArgs;
+                std::vector<Value> strArgs;
+                for (auto arg : expr->children) {
+                    Value value = evaluate(arg);
+                    if (value.isString()) {
+                        strArgs.push_back(std::move(value));
+                    } else {
+                        numArgs.push_back(value.number());
+                    }
+                }
+                
+                return MathFunctions::callStringFunction(expr->value, numArgs, strArgs);
             }
             
         case NODE_ARRAY_ACCESS:
@@ -1056,45 +1683,13 @@ double AltairBasicInterpreter::evaluateExpression(std::shared_ptr<ASTNode> expr)
                 if (expr->children.size() < 2) {
                     throw std::runtime_error("SYNTAX ERROR");
                 }
-                auto arrayName = expr->children[0];
                 
-                // Check if this is actually a user-defined function call
-                if (userDefinedFunctions.find(arrayName->value) != userDefinedFunctions.end()) {
-                    if (expr->children.size() != 2) {
-                        throw std::runtime_error("SYNTAX ERROR");
-                    }
-                    
-                    auto& func = userDefinedFunctions[arrayName->value];
-                    double argValue = evaluateExpression(expr->children[1]);
-                    
-                    // Set parameter value
-                    variables.setNumericVariable(func.parameter, argValue);
-                    
-                    // Evaluate function body
-                    double result = evaluateExpression(func.body);
-                    
-                    return result;
-                }
-                
-                // Check if this is a string array - if so, throw TYPE MISMATCH
-                if (arrayName->value.back() == '$') {
-                    throw std::runtime_error("TYPE MISMATCH");
+                // FN calls parse as array accesses with a function slot
+                if (expr->slot >= 0) {
+                    return callUserFunction(*expr);
                 }
                 
-                if (expr->children.size() == 2) {
-                    // Single dimension: A(1)
-                    auto indexExpr = expr->children[1];
-                    int index = static_cast<int>(evaluateExpression(indexExpr));
-                    return variables.getArrayElement(arrayName->value, index);
-                } else {
-                    // Multi-dimensional: A(1,2,3)
-                    std::vector<int> indices;
-                    for (size_t i = 1; i < expr->children.size(); i++) {
-                        int index = static_cast<int>(evaluateExpression(expr->children[i]));
-                        indices.push_back(index);
-                    }
-                    return variables.getArrayElement(arrayName->value, indices);
-                }
+                return readElement(expr);
             }
             
         default:
@@ -1102,77 +1697,132 @@ double AltairBasicInterpreter::evaluateExpression(std::shared_ptr<ASTNode> expr)
     }
 }
 
-std::string AltairBasicInterpreter::evaluateStringExpression(std::shared_ptr<ASTNode> expr) {
+double AltairBasicInterpreter::evaluateExpression(std::shared_ptr<ASTNode> expr) {
+    Value value = evaluate(expr);
+    if (value.isString()) {
+        throw std::runtime_error("TYPE MISMATCH");
+    }
+    return value.number();
+}
+
+// Whether a condition holds: nonzero is true in BASIC. Comparisons, AND, OR
+// and NOT give a bool directly instead of going through -1 and 0, so an IF
+// branches on the comparison itself.
+bool AltairBasicInterpreter::isTrue(const std::shared_ptr<ASTNode>& condition) {
+    const ASTNode& expr = *condition;
+    if (debug || (expr.hoistSlot >= 0 && hoistingActive)) {
+        return evaluateExpression(condition) != 0.0;
+    }
+    
+    if (expr.type == NODE_UNARY_OP && expr.value == "NOT") {
+        return !isTrue(expr.children[0]);
+    }
+    if (expr.type != NODE_BINARY_OP) {
+        return evaluateExpression(condition) != 0.0;
+    }
+    
+    switch (expr.operator_type) {
+        case OP_AND: {
+            // Both sides are evaluated, as they are for a numeric AND
+            bool left = isTrue(expr.children[0]);
+            bool right = isTrue(expr.children[1]);
+            return left && right;
+        }
+        case OP_OR: {
+            bool left = isTrue(expr.children[0]);
+            bool right = isTrue(expr.children[1]);
+            return left || right;
+        }
+        case OP_EQUAL:
+        case OP_NOT_EQUAL:
+        case OP_LESS:
+        case OP_LESS_EQUAL:
+        case OP_GREATER:
+        case OP_GREATER_EQUAL:
+            break;
+        default:
+            return evaluateExpression(condition) != 0.0;
+    }
+    
+    if (isStringOperand(*expr.children[0]) || isStringOperand(*expr.children[1])) {
+        return evaluateExpression(condition) != 0.0;
+    }
+    Value left = evaluate(expr.children[0]);
+    Value right = evaluate(expr.children[1]);
+    if (left.isString() || right.isString()) {
+        if (!left.isString() || !right.isString()) {
+            throw std::runtime_error("TYPE MISMATCH");
+        }
+        return stringOperation(expr.operator_type, left.text(), right.text()).number() != 0.0;
+    }
+    
+    double l = left.number();
+    double r = right.number();
+    switch (expr.operator_type) {
+        case OP_EQUAL: return l == r;
+        case OP_NOT_EQUAL: return l != r;
+        case OP_LESS: return l < r;
+        case OP_LESS_EQUAL: return l <= r;
+        case OP_GREATER: return l > r;
+        default: return l >= r;
+    }
+}
+
+Value AltairBasicInterpreter::evaluateStringExpression(std::shared_ptr<ASTNode> expr) {
+    Value value = evaluate(expr);
+    if (!value.isString()) {
+        throw std::runtime_error("TYPE MISMATCH");
+    }
+    return value;
+}
+
+// Evaluates a string expression without copying when the result is a literal,
+// a variable, an array element or a LEFT$/RIGHT$/MID$ of one of those. A result
+// that has to be built is kept in scratch, which must outlive the view.
+StringView AltairBasicInterpreter::evaluateStringView(std::shared_ptr<ASTNode> expr, Value& scratch) {
+    if (expr->hoistSlot >= 0 && hoistingActive) {
+        scratch = hoistedValue(expr);
+        if (!scratch.isString()) {
+            throw std::runtime_error("TYPE MISMATCH");
+        }
+        return scratch.text();
+    }
+    
     switch (expr->type) {
         case NODE_STRING:
-            return expr->value;
+            return expr->text.text();
             
         case NODE_VARIABLE:
-            // String variable access: A$, G2$, etc.
             if (expr->value.back() == '$') {
-                return variables.getStringVariable(expr->value);
-            } else {
-                throw std::runtime_error("TYPE MISMATCH");
+                return expr->slot < 0 ? StringView() : variables.scalar(expr->slot).text();
             }
+            break;
             
         case NODE_ARRAY_ACCESS:
-            {
-                if (expr->children.size() < 2) {
-                    throw std::runtime_error("SYNTAX ERROR");
-                }
-                auto arrayName = expr->children[0];
-                
-                // Check if this is a string array
-                if (arrayName->value.back() == '$') {
-                    if (expr->children.size() == 2) {
-                        // Single dimension: A$(1)
-                        auto indexExpr = expr->children[1];
-                        int index = static_cast<int>(evaluateExpression(indexExpr));
-                        return variables.getStringArrayElement(arrayName->value, index);
-                    } else {
-                        // Multi-dimensional: A$(1,2,3)
-                        std::vector<int> indices;
-                        for (size_t i = 1; i < expr->children.size(); i++) {
-                            int index = static_cast<int>(evaluateExpression(expr->children[i]));
-                            indices.push_back(index);
-                        }
-                        return variables.getStringArrayElement(arrayName->value, indices);
-                    }
-                } else {
-                    throw std::runtime_error("TYPE MISMATCH");
-                }
+            if (expr->children.size() >= 2 && expr->children[0]->value.back() == '$') {
+                return readElement(expr).text();
             }
+            break;
             
         case NODE_STRING_FUNCTION_CALL:
-            {
-                std::vector<double> numArgs;
-                std::vector<std::string> strArgs;
-                
-                for (auto arg : expr->children) {
-                    if (arg->type == NODE_STRING) {
-                        strArgs.push_back(arg->value);
-                    } else if (arg->type == NODE_VARIABLE && arg->value.back() == '$') {
-                        strArgs.push_back(variables.getStringVariable(arg->value));
-                    } else if (arg->type == NODE_STRING_FUNCTION_CALL) {
-                        strArgs.push_back(evaluateStringExpression(arg));
-                    } else {
-                        numArgs.push_back(evaluateExpression(arg));
-                    }
+            if (isSubstringCall(*expr)) {
+                StringView source = evaluateStringView(expr->children[0], scratch);
+                double first = evaluateExpression(expr->children[1]);
+                if (expr->value == "LEFT$") {
+                    return MathFunctions::left_func(source, first);
+                } else if (expr->value == "RIGHT$") {
+                    return MathFunctions::right_func(source, first);
                 }
-                
-                return MathFunctions::callStringFunction(expr->value, numArgs, strArgs);
-            }
-        
-        case NODE_BINARY_OP:
-            if (expr->operator_type == OP_PLUS) {
-                return evaluateStringExpression(expr->children[0]) + evaluateStringExpression(expr->children[1]);
-            } else {
-                throw std::runtime_error("TYPE MISMATCH");
+                return MathFunctions::mid_func(source, first, evaluateExpression(expr->children[2]));
             }
+            break;
             
         default:
-            throw std::runtime_error("TYPE MISMATCH");
+            break;
     }
+    
+    scratch = evaluateStringExpression(expr);
+    return scratch.text();
 }
 
 int AltairBasicInterpreter::getNextLineNumber(int currentLineNum) {
@@ -1239,8 +1889,22 @@ void AltairBasicInterpreter::gotoStatement(int lineNumber, int statementIndex) {
 }
 
 void AltairBasicInterpreter::cleanupForLoopStackOnGoto(int fromLine, int toLine) {
+    // Most jumps leave no loop or cross no NEXT, which the line table answers
+    // without scanning the program
+    if (forLoopStack.empty()) {
+        return;
+    }
+    if (!dataTableStale) {
+        int first = toLine < fromLine ? toLine + 1 : fromLine + 1;
+        int last = toLine < fromLine ? fromLine : toLine - 1;
+        auto next = std::lower_bound(nextLines.begin(), nextLines.end(), first);
+        if (next == nextLines.end() || *next > last) {
+            return;
+        }
+    }
+    
     // Collect all NEXT statements that are being jumped over
-    std::set<std::string> jumpedOverVariables;
+    std::set<int> jumpedOverVariables;
     
     int startLine = std::min(fromLine, toLine);
     int endLine = std::max(fromLine, toLine);
@@ -1254,11 +1918,11 @@ void AltairBasicInterpreter::cleanupForLoopStackOnGoto(int fromLine, int toLine)
                 if (stmt->keyword == KW_NEXT) {
                     // This NEXT is being jumped over backwards - find its variable
                     if (!stmt->children.empty()) {
-                        jumpedOverVariables.insert(stmt->children[0]->value);
+                        jumpedOverVariables.insert(stmt->children[0]->slot);
                     } else {
                         // NEXT without explicit variable - matches most recent FOR
                         if (!forLoopStack.empty()) {
-                            jumpedOverVariables.insert(forLoopStack.top().variable);
+                            jumpedOverVariables.insert(forLoopStack.top().slot);
                         }
                     }
                 }
@@ -1272,11 +1936,11 @@ void AltairBasicInterpreter::cleanupForLoopStackOnGoto(int fromLine, int toLine)
                 if (stmt->keyword == KW_NEXT) {
                     // This NEXT is being jumped over - find its variable
                     if (!stmt->children.empty()) {
-                        jumpedOverVariables.insert(stmt->children[0]->value);
+                        jumpedOverVariables.insert(stmt->children[0]->slot);
                     } else {
                         // NEXT without explicit variable - matches most recent FOR
                         if (!forLoopStack.empty()) {
-                            jumpedOverVariables.insert(forLoopStack.top().variable);
+                            jumpedOverVariables.insert(forLoopStack.top().slot);
                         }
                     }
                 }
@@ -1290,7 +1954,7 @@ void AltairBasicInterpreter::cleanupForLoopStackOnGoto(int fromLine, int toLine)
         auto loopState = forLoopStack.top();
         forLoopStack.pop();
         
-        if (jumpedOverVariables.find(loopState.variable) == jumpedOverVariables.end()) {
+        if (jumpedOverVariables.find(loopState.slot) == jumpedOverVariables.end()) {
             // This loop's NEXT is not jumped over, keep it
             tempStack.push(loopState);
         }
@@ -1304,23 +1968,374 @@ void AltairBasicInterpreter::cleanupForLoopStackOnGoto(int fromLine, int toLine)
     }
 }
 
+void AltairBasicInterpreter::prepareLoopHoisting() {
+    std::call_once(loopAnalysis->analyzed, [this]() {
+        std::vector<std::shared_ptr<ASTNode>> lines;
+        for (const auto& entry : program) {
+            lines.push_back(entry.second.ast);
+        }
+        loopAnalysis->analyze(lines);
+    });
+    hoistedValues.assign(loopAnalysis->slotLoops.size(), Value());
+    hoistedStamps.assign(loopAnalysis->slotLoops.size(), 0);
+    loopActivations.assign(loopAnalysis->loopCount, 0);
+}
+
+void AltairBasicInterpreter::prepareIntegers() {
+    std::call_once(integerAnalysis->analyzed, [this]() {
+        std::vector<std::shared_ptr<ASTNode>> lines;
+        for (const auto& entry : program) {
+            lines.push_back(entry.second.ast);
+        }
+        integerAnalysis->analyze(lines);
+    });
+}
+
+void AltairBasicInterpreter::prepareArrayLoops() {
+    std::call_once(arrayLoopAnalysis->analyzed, [this]() {
+        std::vector<std::shared_ptr<ASTNode>> lines;
+        for (const auto& entry : program) {
+            lines.push_back(entry.second.ast);
+        }
+        arrayLoopAnalysis->analyze(lines);
+    });
+}
+
+void AltairBasicInterpreter::prepareJumps() {
+    std::call_once(jumpAnalysis->analyzed, [this]() {
+        std::vector<std::pair<int, std::shared_ptr<ASTNode>>> lines;
+        for (const auto& entry : program) {
+            lines.emplace_back(entry.first, entry.second.ast);
+        }
+        jumpAnalysis->analyze(lines);
+    });
+}
+
+// Runs all but the last iteration of an array loop natively and leaves the
+// counter at the value of the first iteration not run. The interpreter then
+// carries on into the body as usual, so the last iteration and its NEXT leave
+// the counter and the loop stack exactly as the interpreted loop would.
+//
+// Subscripts are checked for the whole run before it starts, and a chunk of
+// iterations in which an operation would raise an error is undone. Either
+// way the interpreter takes over from the first iteration not run, and
+// SUBSCRIPT OUT OF RANGE or DIVISION BY ZERO is raised where it always was.
+void AltairBasicInterpreter::runArrayLoop(const ArrayLoop& loop, double start, double end, double step) {
+    // Counter values must be integers a number holds exactly
+    const double limit = singlePrecision ? 16777216.0 : 9007199254740992.0;
+    if (start != std::trunc(start) || std::fabs(start) > limit || (start == 0 && std::signbit(start)) ||
+        step != std::trunc(step) || step == 0 || std::fabs(step) > limit || std::isnan(end)) {
+        return;
+    }
+    double last = step > 0 ? std::floor(std::min(end, limit)) : std::ceil(std::max(end, -limit));
+    int64_t first = static_cast<int64_t>(start);
+    int64_t stride = static_cast<int64_t>(step);
+    int64_t iterations = (static_cast<int64_t>(last) - first) / stride;
+    if (iterations < 1) {
+        return;
+    }
+    int64_t low = std::min(first, first + (iterations - 1) * stride);
+    int64_t high = std::max(first, first + (iterations - 1) * stride);
+    
+    // Only dense arrays already dimensioned, with every element in range
+    auto elements = [&](int slot, int offset) -> Value* {
+        ValueArray* array = variables.getArray(slot, false);
+        if (!array || array->isPaged() || low + offset < 0 || high + offset >= array->shape.size) {
+            return nullptr;
+        }
+        return array->data.data();
+    };
+    std::vector<const Value*> arrays(loop.ops.size(), nullptr);
+    std::vector<double> values(loop.ops.size(), 0.0);
+    for (size_t i = 0; i < loop.ops.size(); i++) {
+        const KernelOp& op = loop.ops[i];
+        if (op.kind == KernelOp::ELEMENT) {
+            arrays[i] = elements(op.slot, op.offset);
+            if (!arrays[i]) {
+                return;
+            }
+        } else if (op.kind == KernelOp::CONSTANT) {
+            values[i] = op.constant;
+        } else if (op.kind == KernelOp::INVARIANT) {
+            try {
+                Value value = evaluate(op.expr);
+                if (value.isString()) {
+                    return;
+                }
+                values[i] = value.number();
+            } catch (const std::exception&) {
+                return;
+            }
+        }
+    }
+    std::vector<Value*> targets;
+    for (const KernelStatement& statement : loop.statements) {
+        targets.push_back(elements(statement.slot, statement.offset));
+        if (!targets.back()) {
+            return;
+        }
+    }
+    
+    std::vector<double> scratch;
+    std::vector<double> result(ArrayLoop::CHUNK);
+    std::vector<double> saved;
+    int64_t done = 0;
+    while (done < iterations) {
+        int count = static_cast<int>(std::min<int64_t>(ArrayLoop::CHUNK, iterations - done));
+        int64_t counter = first + done * stride;
+        
+        saved.clear();
+        for (size_t s = 0; s < loop.statements.size(); s++) {
+            const Value* target = targets[s] + (counter + loop.statements[s].offset);
+            for (int k = 0; k < count; k++) {
+                saved.push_back(target[k * stride].number());
+            }
+        }
+        
+        size_t s = 0;
+        for (; s < loop.statements.size(); s++) {
+            if (!loop.evaluate(loop.statements[s], values, arrays, counter, stride, count,
+                               singlePrecision ? &toSingle : nullptr, result.data(), scratch)) {
+                break;
+            }
+            Value* target = targets[s] + (counter + loop.statements[s].offset);
+            for (int k = 0; k < count; k++) {
+                target[k * stride] = Value(result[k]);
+            }
+        }
+        if (s < loop.statements.size()) {
+            // Put back what this chunk stored, last statement first
+            while (s-- > 0) {
+                Value* target = targets[s] + (counter + loop.statements[s].offset);
+                for (int k = 0; k < count; k++) {
+                    target[k * stride] = Value(saved[s * count + k]);
+                }
+            }
+            break;
+        }
+        done += count;
+    }
+    
+    if (done > 0) {
+        variables.scalar(loop.counter) = Value(static_cast<double>(first + done * stride));
+    }
+}
+
+// Integers up to 2^53 (2^24 in single precision) are held exactly, so integer
+// arithmetic that stays within that range gives what floating point would.
+// Anything else, including -0, is left to the floating-point path.
+static bool exactInteger(double value, int64_t limit, int64_t& result) {
+    if (!(value >= -limit && value <= limit)) {
+        return false;
+    }
+    result = static_cast<int64_t>(value);
+    return result == value && (result != 0 || !std::signbit(value));
+}
+
+static bool inRange(int64_t value, int64_t limit) {
+    return value >= -limit && value <= limit;
+}
+
+// 0 times a negative number is -0 in floating point
+static bool exactProduct(int64_t left, int64_t right, int64_t limit, int64_t& result) {
+    return !__builtin_mul_overflow(left, right, &result) && inRange(result, limit) &&
+           (result != 0 || (left >= 0 && right >= 0));
+}
+
+// The value of an integral expression, computed with integers. Returns false
+// if an operand or result isn't an integer held exactly; the caller then
+// evaluates the expression as usual. Operator nodes must carry the integral
+// flag, which guarantees their operands are numeric and side-effect free.
+bool AltairBasicInterpreter::integerValue(const ASTNode& expr, int64_t& result) {
+    const int64_t limit = singlePrecision ? (int64_t(1) << 24) : (int64_t(1) << 53);
+    int64_t left, right;
+    switch (expr.type) {
+        case NODE_NUMBER:
+            return !expr.text.isString() && exactInteger(expr.text.number(), limit, result);
+            
+        case NODE_VARIABLE: {
+            if (expr.slot < 0) {
+                result = 0;
+                return expr.value.back() != '$';
+            }
+            const Value& value = variables.scalar(expr.slot);
+            return !value.isString() && exactInteger(value.number(), limit, result);
+        }
+            
+        case NODE_UNARY_OP:
+            if (!expr.integral || !integerValue(*expr.children[0], left)) {
+                return false;
+            }
+            if (expr.operator_type == OP_MINUS) {
+                result = -left;
+                return left != 0;
+            }
+            result = left == 0 ? -1 : 0;
+            return true;
+            
+        case NODE_BINARY_OP:
+            if (!expr.integral || !integerValue(*expr.children[0], left)) {
+                return false;
+            }
+            switch (expr.operator_type) {
+                case OP_SQUARE:
+                    return exactProduct(left, left, limit, result);
+                case OP_CUBE:
+                    return exactProduct(left, left, limit, right) && exactProduct(right, left, limit, result);
+                case OP_FOURTH_POWER:
+                    return exactProduct(left, left, limit, right) && exactProduct(right, right, limit, result);
+                default:
+                    break;
+            }
+            if (!integerValue(*expr.children[1], right)) {
+                return false;
+            }
+            switch (expr.operator_type) {
+                case OP_PLUS: result = left + right; return inRange(result, limit);
+                case OP_MINUS: result = left - right; return inRange(result, limit);
+                case OP_MULTIPLY: return exactProduct(left, right, limit, result);
+                case OP_EQUAL: result = left == right ? -1 : 0; return true;
+                case OP_NOT_EQUAL: result = left != right ? -1 : 0; return true;
+                case OP_LESS: result = left < right ? -1 : 0; return true;
+                case OP_LESS_EQUAL: result = left <= right ? -1 : 0; return true;
+                case OP_GREATER: result = left > right ? -1 : 0; return true;
+                case OP_GREATER_EQUAL: result = left >= right ? -1 : 0; return true;
+                case OP_AND: result = left != 0 && right != 0 ? -1 : 0; return true;
+                case OP_OR: result = left != 0 || right != 0 ? -1 : 0; return true;
+                default: return false;
+            }
+            
+        case NODE_FUNCTION_CALL:
+            if (!expr.integral) {
+                return false;
+            }
+            if (expr.value == "INT") {
+                return integerValue(*expr.children[0], result) ||
+                       exactInteger(std::floor(evaluateExpression(expr.children[0])), limit, result);
+            }
+            if (!integerValue(*expr.children[0], left)) {
+                return false;
+            }
+            if (expr.value == "ABS") {
+                result = left < 0 ? -left : left;
+            } else {
+                result = (left > 0) - (left < 0);
+            }
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
+void AltairBasicInterpreter::resetLoopActivations() {
+    std::fill(loopActivations.begin(), loopActivations.end(), 0);
+    std::fill(hoistedStamps.begin(), hoistedStamps.end(), 0);
+    std::fill(hoistedValues.begin(), hoistedValues.end(), Value());
+}
+
+// A hoisted expression is evaluated the first time it is reached in each
+// activation of its loop and read back after that. Outside the loop it is
+// evaluated as usual.
+Value AltairBasicInterpreter::hoistedValue(const std::shared_ptr<ASTNode>& expr) {
+    size_t slot = static_cast<size_t>(expr->hoistSlot);
+    uint64_t activation = loopActivations[loopAnalysis->slotLoops[slot]];
+    if (activation == 0) {
+        return evaluateNode(expr);
+    }
+    if (hoistedStamps[slot] != activation) {
+        hoistedValues[slot] = evaluateNode(expr);
+        hoistedStamps[slot] = activation;
+    }
+    return hoistedValues[slot];
+}
+
 void AltairBasicInterpreter::collectDataItems() {
     dataItems.clear();
+    dataLineOffsets.clear();
     dataPointer = 0;
+    dataTableStale = false;
     
+    nextLines.clear();
     for (const auto& pair : program) {
+        dataLineOffsets[pair.first] = dataItems.size();
         auto line = pair.second.ast;
         for (auto stmt : line->children) {
+            if (stmt->keyword == KW_NEXT && (nextLines.empty() || nextLines.back() != pair.first)) {
+                nextLines.push_back(pair.first);
+            }
             if (stmt->keyword == KW_DATA) {
                 for (auto data : stmt->children) {
-                    dataItems.push_back(data->value);
+                    // Unquoted and quoted items alike READ as numbers if they start with one
+                    double number = 0.0;
+                    bool isNumeric = true;
+                    try {
+                        number = std::stod(data->value);
+                    } catch (const std::exception&) {
+                        isNumeric = false;
+                    }
+                    dataItems.emplace_back(data->text, number, isNumeric);
                 }
             }
         }
     }
 }
 
+double AltairBasicInterpreter::toSingle(double value) {
+    float single = static_cast<float>(value);
+    if (std::isinf(single) && !std::isinf(value)) {
+        throw std::runtime_error("OVERFLOW");
+    }
+    return single;
+}
+
+// Altair BASIC's output: at most 6 significant digits, no zero before the
+// point, and E notation outside .01 <= |x| < 1E+06
+static std::string formatAltair(double value) {
+    std::string sign = value < 0 ? "-" : " ";
+    if (value == 0) {
+        return " 0 ";
+    }
+    if (std::isnan(value)) {
+        return "nan ";
+    }
+    if (std::isinf(value)) {
+        return sign + "inf ";
+    }
+    
+    // Round to 6 digits first so 999999.7 becomes 1E+06, not 1000000
+    char scientific[32];
+    std::snprintf(scientific, sizeof(scientific), "%.5e", std::fabs(value));
+    std::string digits = std::string(1, scientific[0]) + std::string(scientific + 2, 5);
+    int exponent = std::atoi(std::strchr(scientific, 'e') + 1);
+    digits.erase(digits.find_last_not_of('0') + 1);
+    
+    std::string body;
+    if (exponent >= 6 || exponent < -2) {
+        body = digits.substr(0, 1);
+        if (digits.size() > 1) {
+            body += "." + digits.substr(1);
+        }
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), "E%c%02d", exponent < 0 ? '-' : '+', std::abs(exponent));
+        body += suffix;
+    } else if (exponent >= 0) {
+        digits.resize(std::max(digits.size(), static_cast<size_t>(exponent) + 1), '0');
+        body = digits.substr(0, exponent + 1);
+        if (digits.size() > static_cast<size_t>(exponent) + 1) {
+            body += "." + digits.substr(exponent + 1);
+        }
+    } else {
+        body = "." + std::string(-exponent - 1, '0') + digits;
+    }
+    return sign + body + " ";
+}
+
 std::string AltairBasicInterpreter::formatNumber(double value) {
+    if (singlePrecision) {
+        return formatAltair(value);
+    }
+    
     std::ostringstream oss;
     
     // Authentic BASIC number formatting
@@ -1351,9 +2366,154 @@ std::string AltairBasicInterpreter::formatNumber(double value) {
     return oss.str();
 }
 
+void AltairBasicInterpreter::setIdleSpill(int seconds, const std::string& directory) {
+    idleSpillSeconds = seconds;
+    spillDirectory = directory.empty() ? "/tmp" : directory;
+}
+
+void AltairBasicInterpreter::waitForTerminalInput() {
+#ifndef __EMSCRIPTEN__
+    // Only a terminal is worth watching: piped input is never idle for long,
+    // and poll() cannot see data already sitting in the stdio buffer.
+    if (idleSpillSeconds > 0 && in == &std::cin && isatty(STDIN_FILENO)) {
+        out->flush();
+        struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+        int timeout = idleSpillSeconds > INT_MAX / 1000 ? INT_MAX : idleSpillSeconds * 1000;
+        if (poll(&pfd, 1, timeout) == 0) {
+            spillSession();
+        }
+    }
+#endif
+}
+
+bool AltairBasicInterpreter::readInputLine(std::string& line) {
+    // PRINT doesn't flush, so show everything up to the prompt before waiting
+    out->flush();
+    waitForTerminalInput();
+    bool ok = static_cast<bool>(std::getline(*in, line));
+    if (isSpilled()) {
+        rehydrateSession();
+    }
+    return ok;
+}
+
+void AltairBasicInterpreter::spillSession() {
+    if (isSpilled()) return;
+    
+    SpillWriter writer;
+    variables.save(writer);
+    
+    // Stacks are written bottom to top so they can be pushed back in order.
+    // They're walked on copies: nothing is released until the file is written.
+    std::vector<ForLoopState> loops;
+    for (auto stack = forLoopStack; !stack.empty(); stack.pop()) {
+        loops.push_back(stack.top());
+    }
+    writer.putInt(loops.size());
+    for (auto it = loops.rbegin(); it != loops.rend(); ++it) {
+        writer.putString(VariableManager::nameForSlot(it->slot));
+        writer.putDouble(it->endValue);
+        writer.putDouble(it->stepValue);
+        writer.putInt(it->returnLine);
+        writer.putInt(it->returnStatementIndex);
+    }
+    
+    std::vector<CallFrame> frames;
+    for (auto stack = callStack; !stack.empty(); stack.pop()) {
+        frames.push_back(stack.top());
+    }
+    writer.putInt(frames.size());
+    for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+        writer.putInt(it->returnLine);
+        writer.putInt(it->returnStatementIndex);
+    }
+    
+    writer.putInt(dataPointer);
+    writer.putInt(m_currentColumn);
+    rng.save(writer);
+    
+    // Spilling only saves memory, so if the file can't be written the session
+    // simply stays in memory
+    std::string path = spillDirectory + "/altair-ego-XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+        DEBUG_PRINT("Can't spill session to " << spillDirectory);
+        return;
+    }
+    close(fd);
+    try {
+        writeSpillFile(path, writer.data());
+    } catch (const std::exception& e) {
+        std::remove(path.c_str());
+        DEBUG_PRINT("Can't spill session: " << e.what());
+        return;
+    }
+    spillPath = path;
+    
+    // Release everything that can be rebuilt; DATA items are re-collected from the program
+    variables.clearAll();
+    forLoopStack = std::stack<ForLoopState>();
+    callStack = std::stack<CallFrame>();
+    std::vector<DataItem>().swap(dataItems);
+    std::unordered_map<int, size_t>().swap(dataLineOffsets);
+    dataTableStale = true;
+    resetLoopActivations();
+    
+    DEBUG_PRINT("Spilled idle session to " << spillPath);
+}
+
+// If the spill file can't be read back, the suspended program is dropped:
+// the session is left stopped and empty and the error is rethrown, to be
+// reported like any other run-time error
+void AltairBasicInterpreter::rehydrateSession() {
+    if (!isSpilled()) return;
+    
+    std::string path = spillPath;
+    spillPath.clear();
+    DEBUG_PRINT("Rehydrating session from " << path);
+    
+    try {
+        SpillReader reader(readSpillFile(path));
+        std::remove(path.c_str());
+        
+        variables.load(reader);
+        
+        for (int64_t n = reader.getInt(); n > 0; n--) {
+            std::string var = reader.getString();
+            double endValue = reader.getDouble();
+            double stepValue = reader.getDouble();
+            int returnLine = static_cast<int>(reader.getInt());
+            int returnStmtIndex = static_cast<int>(reader.getInt());
+            forLoopStack.push(ForLoopState(VariableManager::slotFor(var), endValue, stepValue, returnLine, returnStmtIndex));
+        }
+        
+        for (int64_t n = reader.getInt(); n > 0; n--) {
+            int returnLine = static_cast<int>(reader.getInt());
+            int returnStmtIndex = static_cast<int>(reader.getInt());
+            callStack.push(CallFrame(returnLine, returnStmtIndex));
+        }
+        
+        collectDataItems();
+        dataPointer = static_cast<size_t>(reader.getInt());
+        m_currentColumn = static_cast<int>(reader.getInt());
+        rng.load(reader);
+    } catch (const std::exception&) {
+        std::remove(path.c_str());
+        variables.clearAll();
+        forLoopStack = std::stack<ForLoopState>();
+        callStack = std::stack<CallFrame>();
+        pendingInput.reset();
+        pendingValues.clear();
+        pendingStatements.clear();
+        suspendedLine.reset();
+        dataPointer = 0;
+        throw;
+    }
+}
+
 void AltairBasicInterpreter::printTabs(int count) {
     for (int i = 0; i < count; ++i) {
-        std::cout << " ";
+        *out << " ";
     }
 }
 
@@ -1361,51 +2521,60 @@ void AltairBasicInterpreter::printStatement(std::shared_ptr<ASTNode> stmt) {
     // Simple reconstruction of statement text for LIST command
     switch (stmt->keyword) {
         case KW_PRINT:
-            std::cout << "PRINT";
+            *out << "PRINT";
             for (auto child : stmt->children) {
                 if (child->type == NODE_STRING && child->value != "," && child->value != ";") {
-                    std::cout << " "" << child->value << """;
+                    *out << " "" << child->value << """;
                 } else if (child->type == NODE_STRING) {
-                    std::cout << child->value;
+                    *out << child->value;
                 } else {
-                    std::cout << " [EXPR]";
+                    *out << " [EXPR]";
                 }
             }
             break;
         case KW_INPUT:
-            std::cout << "INPUT";
+            *out << "INPUT";
             break;
         case KW_LET:
-            std::cout << "LET";
+            *out << "LET";
             break;
         case KW_IF:
-            std::cout << "IF [CONDITION] THEN [ACTION]";
+            *out << "IF [CONDITION] THEN [ACTION]";
             break;
         case KW_FOR:
-            std::cout << "FOR [VAR]=[START] TO [END]";
+            *out << "FOR [VAR]=[START] TO [END]";
             break;
         case KW_GOTO:
-            std::cout << "GOTO";
+            *out << "GOTO";
             if (!stmt->children.empty()) {
-                std::cout << " " << stmt->children[0]->value;
+                *out << " " << stmt->children[0]->value;
             }
             break;
         case KW_GOSUB:
-            std::cout << "GOSUB";
+            *out << "GOSUB";
             if (!stmt->children.empty()) {
-                std::cout << " " << stmt->children[0]->value;
+                *out << " " << stmt->children[0]->value;
             }
             break;
         case KW_RETURN:
-            std::cout << "RETURN";
+            *out << "RETURN";
+            break;
+        case KW_RESTORE:
+            *out << "RESTORE";
+            if (!stmt->children.empty()) {
+                *out << " " << stmt->children[0]->value;
+            }
+            break;
+        case KW_MAT:
+            *out << "MAT " << stmt->value;
             break;
         case KW_REM:
-            std::cout << "REM";
+            *out << "REM";
             if (!stmt->children.empty()) {
-                std::cout << " " << stmt->children[0]->value;
+                *out << " " << stmt->children[0]->value;
             }
             break;
         default:
-            std::cout << "[STATEMENT]";
+            *out << "[STATEMENT]";
     }
 }
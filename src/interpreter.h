@@ -5,29 +5,51 @@
 #include "parser.h"
 #include "variable.h"
 #include "functions.h"
+#include "random.h"
+#include "hoist.h"
+#include "integer.h"
+#include "matrix.h"
+#include "arrayloop.h"
+#include "jump.h"
 #include <map>
+#include <unordered_map>
 #include <stack>
 #include <vector>
 #include <memory>
+#include <iostream>
 
-#define DEBUG_PRINT(x) do { if (debug) { std::cout << "[DEBUG] " << x << std::endl; } } while (0)
+#define DEBUG_PRINT(x) do { if (debug) { *out << "[DEBUG] " << x << std::endl; } } while (0)
 
 struct ProgramLine {
     int lineNumber;
     std::shared_ptr<ASTNode> ast;
+    size_t bytes;       // Size of the parsed line, charged to the program store
     
-    ProgramLine(int num, std::shared_ptr<ASTNode> node) : lineNumber(num), ast(node) {}
+    ProgramLine(int num, std::shared_ptr<ASTNode> node, size_t size = 0) : lineNumber(num), ast(node), bytes(size) {}
 };
 
+// A FOR loop in progress. NEXT updates the counter in its slot and jumps
+// straight to the first statement of the body, both resolved by FOR.
 struct ForLoopState {
-    std::string variable;
+    int slot;           // The counter's numeric variable slot
     double endValue;
     double stepValue;
     int returnLine;
     int returnStatementIndex;
+    int loopId;         // LoopAnalysis id while its hoisted values are live, -1 otherwise
     
-    ForLoopState(const std::string& var, double end, double step, int line, int stmtIndex = -1)
-        : variable(var), endValue(end), stepValue(step), returnLine(line), returnStatementIndex(stmtIndex) {}
+    ForLoopState(int counter, double end, double step, int line, int stmtIndex, int loop = -1)
+        : slot(counter), endValue(end), stepValue(step), returnLine(line), returnStatementIndex(stmtIndex), loopId(loop) {}
+};
+
+// A DATA item, decoded once when the DATA table is built. Numeric READs copy
+// number, string READs copy the item as it was written.
+struct DataItem {
+    Value text;
+    double number;
+    bool isNumeric;     // Whether a numeric READ accepts the item
+    
+    DataItem(const Value& t, double n, bool numeric) : text(t), number(n), isNumeric(numeric) {}
 };
 
 struct CallFrame {
@@ -37,26 +59,33 @@ struct CallFrame {
     CallFrame(int line, int stmtIdx) : returnLine(line), returnStatementIndex(stmtIdx) {}
 };
 
+// A DEF FN compiled for calling: body is a copy of the DEF's expression in
+// which references to the parameter are NODE_PARAMETER nodes, so a call never
+// touches the variable of the same name.
 struct UserDefinedFunction {
-    std::string name;
-    std::string parameter;
+    std::shared_ptr<ASTNode> definition;    // The DEF statement it was compiled from
     std::shared_ptr<ASTNode> body;
-    
-    UserDefinedFunction() = default;
-    UserDefinedFunction(const std::string& n, const std::string& p, std::shared_ptr<ASTNode> b)
-        : name(n), parameter(p), body(b) {}
 };
 
+// Thrown by INPUT in non-blocking mode to unwind back to the host. Deliberately
+// not a std::exception so runtime error handlers don't catch it.
+struct InputSuspended {};
+
 class AltairBasicInterpreter {
 private:
     Lexer lexer;
     Parser parser;
     VariableManager variables;
+    RandomGenerator rng;
     
     std::map<int, ProgramLine> program;
-    std::vector<std::string> dataItems;
+    std::vector<DataItem> dataItems;
+    std::unordered_map<int, size_t> dataLineOffsets;   // First item at or after each program line, for RESTORE n
+    std::vector<int> nextLines;     // Lines with a NEXT statement, ascending, built with the DATA table
     size_t dataPointer;
-    std::map<std::string, UserDefinedFunction> userDefinedFunctions;
+    bool dataTableStale;    // Program edited since the DATA table was built
+    std::vector<UserDefinedFunction> userFunctions;     // By function slot
+    double functionArgument;    // Parameter value of the innermost FN call
     
     std::stack<CallFrame> callStack;
     std::stack<ForLoopState> forLoopStack;
@@ -68,14 +97,87 @@ private:
     bool returningFromSubroutine;
     bool debug;
     int m_currentColumn;
+    std::string printBuffer;    // Output of the PRINT being run, reused between statements
     int on_error_goto_line;
     
+    // Idle INPUT spill
+    int idleSpillSeconds;
+    std::string spillDirectory;
+    std::string spillPath;
+    
+    // Single-precision mode: numbers are rounded to 32-bit floats as they are
+    // produced, as on the original machine, and print with at most 6 digits
+    bool singlePrecision;
+    double narrow(double value) const { return singlePrecision ? toSingle(value) : value; }
+    static double toSingle(double value);
+    
+    // Loop-invariant hoisting. A hoisted value is valid while its stamp equals
+    // the current activation of its loop; activations are renumbered each time
+    // a FOR is entered and zeroed when the loop ends.
+    bool loopHoisting;
+    bool hoistingActive;    // Hoisting on and DEBUG off for the current run
+    std::shared_ptr<LoopAnalysis> loopAnalysis;
+    std::vector<Value> hoistedValues;
+    std::vector<uint64_t> hoistedStamps;
+    std::vector<uint64_t> loopActivations;
+    uint64_t activationCounter;
+    void prepareLoopHoisting();
+    void resetLoopActivations();
+    Value hoistedValue(const std::shared_ptr<ASTNode>& expr);
+    
+    // Integer fast path for expressions IntegerAnalysis flags as integral
+    bool integersActive;    // DEBUG off for the current run
+    std::shared_ptr<IntegerAnalysis> integerAnalysis;
+    void prepareIntegers();
+    bool integerValue(const ASTNode& expr, int64_t& result);
+    int subscript(const std::shared_ptr<ASTNode>& expr);
+    
+    // Native runs of the FOR loops ArrayLoopAnalysis finds
+    bool arrayLoopsActive;  // DEBUG off for the current run
+    std::shared_ptr<ArrayLoopAnalysis> arrayLoopAnalysis;
+    void prepareArrayLoops();
+    void runArrayLoop(const ArrayLoop& loop, double start, double end, double step);
+    
+    // GOTO and GOSUB targets JumpAnalysis resolved for the current program
+    bool jumpsActive;       // DEBUG off for the current run
+    std::shared_ptr<JumpAnalysis> jumpAnalysis;
+    void prepareJumps();
+    
+    // Memory accounting
+    size_t memoryLimit;
+    size_t peakMemory;
+    size_t programBytes;
+    std::ostream* memoryReport;
+    
+    // Program I/O, std::cin/std::cout unless redirected
+    std::istream* in;
+    std::ostream* out;
+    
+    // Non-blocking INPUT: the continuation of a suspended program
+    bool nonBlockingInput;
+    bool inputClosed;
+    std::shared_ptr<ASTNode> pendingInput;
+    std::vector<std::string> pendingValues;
+    std::vector<std::shared_ptr<ASTNode>> pendingStatements;
+    std::shared_ptr<ASTNode> suspendedLine;
+    
     // Execution methods
     void executeProgram();
+    void runProgram(bool resuming);
+    void runPendingStatements();
+    void completeInput(const std::string* line);
     void executeLine(std::shared_ptr<ASTNode> line);
     void executeStatement(std::shared_ptr<ASTNode> stmt);
+    Value evaluate(std::shared_ptr<ASTNode> expr);
+    Value evaluateNode(std::shared_ptr<ASTNode> expr);
+    Value callUserFunction(const ASTNode& call);
     double evaluateExpression(std::shared_ptr<ASTNode> expr);
-    std::string evaluateStringExpression(std::shared_ptr<ASTNode> expr);
+    bool isTrue(const std::shared_ptr<ASTNode>& condition);
+    Value evaluateStringExpression(std::shared_ptr<ASTNode> expr);
+    StringView evaluateStringView(std::shared_ptr<ASTNode> expr, Value& scratch);
+    size_t arrayOffset(const ArrayShape& shape, const ASTNode& access);
+    Value& element(const std::shared_ptr<ASTNode>& access);
+    const Value& readElement(const std::shared_ptr<ASTNode>& access);
     int getNextLineNumber(int currentLineNum);
     void findMatchingNext(int forLineNum);
     void gotoStatement(int lineNum, int statementIndex);
@@ -85,6 +187,8 @@ private:
     void executePrint(std::shared_ptr<ASTNode> stmt);
     void executeInput(std::shared_ptr<ASTNode> stmt);
     void executeLet(std::shared_ptr<ASTNode> stmt);
+    bool isSelfAppend(const std::string& name, std::shared_ptr<ASTNode> expr);
+    Value evaluateAppendedSuffix(std::shared_ptr<ASTNode> expr);
     void executeIf(std::shared_ptr<ASTNode> stmt);
     void executeFor(std::shared_ptr<ASTNode> stmt);
     void executeNext(std::shared_ptr<ASTNode> stmt);
@@ -93,12 +197,19 @@ private:
     void executeReturn(std::shared_ptr<ASTNode> stmt);
     void executeData(std::shared_ptr<ASTNode> stmt);
     void executeRead(std::shared_ptr<ASTNode> stmt);
+    Value dataValue(bool isString);
     void executeRestore(std::shared_ptr<ASTNode> stmt);
     void executeEnd(std::shared_ptr<ASTNode> stmt);
     void executeStop(std::shared_ptr<ASTNode> stmt);
     void executeOn(std::shared_ptr<ASTNode> stmt);
     void executeDim(std::shared_ptr<ASTNode> stmt);
     void executeDef(std::shared_ptr<ASTNode> stmt);
+    void executeRandomize(std::shared_ptr<ASTNode> stmt);
+    void executeMat(std::shared_ptr<ASTNode> stmt);
+    Matrix loadMatrix(const ASTNode& name);
+    void storeMatrix(const ASTNode& name, const Matrix& matrix);
+    void readMatrix(const ASTNode& name);
+    void printMatrix(const ASTNode& name, bool packed);
     
     // Command execution methods
     void executeList();
@@ -110,14 +221,47 @@ private:
     bool isCommand(std::shared_ptr<ASTNode> stmt);
     void gotoLine(int lineNumber);
     void collectDataItems();
+    void programChanged();
     std::string formatNumber(double value);
     void printTabs(int count);
     void printStatement(std::shared_ptr<ASTNode> stmt);
+    bool readInputLine(std::string& line);
+    bool acceptInputLine(std::shared_ptr<ASTNode> stmt, const std::string& line, std::vector<std::string>& values);
+    void checkMemory(size_t extra = 0);
+    void reportPeakMemory();
     
 public:
     AltairBasicInterpreter();
     void processLine(const std::string& input);
     void executeRun();
+    void setStreams(std::istream& input, std::ostream& output);
+    void shareProgram(const AltairBasicInterpreter& other);
+    void seedRandom(uint64_t seed) { rng.seed(seed); }
+    void setSinglePrecision(bool enabled) { singlePrecision = enabled; }
+    void setLoopHoisting(bool enabled) { loopHoisting = enabled; }
+    
+    // Program store, variables, arrays, strings and stacks are charged against
+    // a per-session limit; going over it raises OUT OF MEMORY. FRE(0) returns
+    // what is left. With a report stream, peak usage is written there whenever
+    // a program ends.
+    static const size_t DEFAULT_MEMORY_LIMIT = 32 * 1024 * 1024;
+    void setMemoryLimit(size_t bytes) { memoryLimit = bytes; }
+    void setMemoryReport(std::ostream& report) { memoryReport = &report; }
+    size_t memoryUsed() const;
+    size_t peakMemoryUsed() const { return peakMemory; }
+    
+    // With non-blocking input, INPUT returns control to the caller instead of
+    // reading a line; the next processLine() call supplies the answer.
+    void setNonBlockingInput(bool enabled);
+    bool isAwaitingInput() const { return pendingInput != nullptr; }
+    void closeInput();
+    
+    // Sessions idle at an INPUT prompt longer than the threshold are spilled to disk
+    void setIdleSpill(int seconds, const std::string& directory);
+    void spillSession();
+    void rehydrateSession();
+    void waitForTerminalInput();
+    bool isSpilled() const { return !spillPath.empty(); }
 };
 
 #endif
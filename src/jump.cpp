@@ -0,0 +1,76 @@
+#include "jump.h"
+#include <algorithm>
+
+namespace {
+
+// The lines a jump from one line to another passes over, as
+// cleanupForLoopStackOnGoto scans them: a backward jump passes over its own
+// line, a forward one stops short of its target
+bool crossesNext(int fromLine, int toLine, const std::vector<int>& nextLines) {
+    int first = toLine < fromLine ? toLine + 1 : fromLine + 1;
+    int last = toLine < fromLine ? fromLine : toLine - 1;
+    auto next = std::lower_bound(nextLines.begin(), nextLines.end(), first);
+    return next != nextLines.end() && *next <= last;
+}
+
+void resolve(ASTNode& stmt, int lineNumber, const std::vector<int>& lineNumbers, const std::vector<int>& nextLines) {
+    if (stmt.type != NODE_STATEMENT) {
+        return;
+    }
+    if (stmt.keyword == KW_IF) {
+        for (size_t i = 1; i < stmt.children.size(); i++) {
+            resolve(*stmt.children[i], lineNumber, lineNumbers, nextLines);
+        }
+        return;
+    }
+    if (stmt.keyword != KW_GOTO && stmt.keyword != KW_GOSUB) {
+        return;
+    }
+
+    stmt.jumpLine = -1;
+    stmt.jumpCrossesNext = false;
+    if (stmt.children.size() != 1) {
+        return;
+    }
+    // Literals are decoded by optimizeLine when the line is entered
+    const ASTNode& target = *stmt.children[0];
+    if (target.type != NODE_NUMBER || target.text.isString()) {
+        return;
+    }
+    double number = target.text.number();
+    if (number < 0 || number > lineNumbers.back()) {
+        return;
+    }
+    int toLine = static_cast<int>(number);
+    if (!std::binary_search(lineNumbers.begin(), lineNumbers.end(), toLine)) {
+        return;
+    }
+    stmt.jumpLine = toLine;
+    stmt.jumpCrossesNext = crossesNext(lineNumber, toLine, nextLines);
+}
+
+} // namespace
+
+void JumpAnalysis::analyze(const std::vector<std::pair<int, std::shared_ptr<ASTNode>>>& lines) {
+    if (lines.empty()) {
+        return;
+    }
+
+    std::vector<int> lineNumbers;
+    std::vector<int> nextLines;
+    for (const auto& line : lines) {
+        lineNumbers.push_back(line.first);
+        for (const auto& stmt : line.second->children) {
+            if (stmt->keyword == KW_NEXT) {
+                nextLines.push_back(line.first);
+                break;
+            }
+        }
+    }
+
+    for (const auto& line : lines) {
+        for (const auto& stmt : line.second->children) {
+            resolve(*stmt, line.first, lineNumbers, nextLines);
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef JUMP_H
+#define JUMP_H
+
+#include "parser.h"
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Targets of the program's GOTO, GOSUB and IF ... THEN <line> statements. A
+// jump to a literal line number that exists is given the number in jumpLine,
+// and jumpCrossesNext says whether a NEXT lies in the lines it passes over, so
+// a taken jump neither evaluates the number, looks the line up to check it
+// exists, nor searches for loops it leaves. Any other jump keeps jumpLine -1
+// and is resolved when it runs. Like LoopAnalysis, this runs once per edited
+// program and its result is shared by every interpreter running it.
+struct JumpAnalysis {
+    std::once_flag analyzed;
+
+    // Takes the program's line numbers and lines in line-number order
+    void analyze(const std::vector<std::pair<int, std::shared_ptr<ASTNode>>>& lines);
+};
+
+#endif
@@ -8,9 +8,9 @@
 std::map<std::string, KeywordType> Lexer::keywords;
 
 Lexer::Lexer() : position(0), line(1), column(1) {
-    if (keywords.empty()) {
-        initializeKeywords();
-    }
+    // Function-local static so concurrent interpreters initialize the table once
+    static const bool keywordsInitialized = (initializeKeywords(), true);
+    (void)keywordsInitialized;
 }
 
 void Lexer::initializeKeywords() {
@@ -45,6 +45,8 @@ void Lexer::initializeKeywords() {
     keywords["ON"] = KW_ON;
     keywords["STEP"] = KW_STEP;
     keywords["ERROR"] = KW_ERROR;
+    keywords["RANDOMIZE"] = KW_RANDOMIZE;
+    keywords["MAT"] = KW_MAT;
 }
 
 std::string Lexer::getLineText(int lineNumber) {
@@ -21,14 +21,18 @@ enum KeywordType {
     KW_FOR, KW_TO, KW_NEXT, KW_GOTO, KW_GOSUB, KW_RETURN,
     KW_REM, KW_DATA, KW_READ, KW_RESTORE, KW_END, KW_STOP,
     KW_LIST, KW_NEW, KW_RUN, KW_CLEAR, KW_AND, KW_OR, KW_NOT,
-    KW_DIM, KW_DEF, KW_FN, KW_ON, KW_STEP, KW_ERROR
+    KW_DIM, KW_DEF, KW_FN, KW_ON, KW_STEP, KW_ERROR,
+    KW_RANDOMIZE, KW_MAT
 };
 
 enum OperatorType {
     OP_PLUS, OP_MINUS, OP_MULTIPLY, OP_DIVIDE, OP_POWER,
     OP_EQUAL, OP_NOT_EQUAL, OP_LESS, OP_LESS_EQUAL,
     OP_GREATER, OP_GREATER_EQUAL, OP_ASSIGN,
-    OP_AND, OP_OR
+    OP_AND, OP_OR,
+    // Cheaper forms of ^ and / with a constant right operand, produced by the
+    // optimizer (optimize.h) and never by the lexer
+    OP_SQUARE, OP_CUBE, OP_FOURTH_POWER, OP_SQUARE_ROOT, OP_DIVIDE_NONZERO
 };
 
 struct Token {
@@ -1,8 +1,10 @@
 #include "interpreter.h"
+#include "batch.h"
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <cstdlib>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -87,12 +89,81 @@ int main(int argc, char* argv[]) {
 
 int main(int argc, char* argv[]) {
     AltairBasicInterpreter interpreter;
+    const char* programFile = nullptr;
+    int spillAfter = 0;
+    std::string spillDir;
+    BatchOptions batch;
+    bool usageError = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--spill-after" && i + 1 < argc) {
+            spillAfter = std::atoi(argv[++i]);
+        } else if (arg == "--spill-dir" && i + 1 < argc) {
+            spillDir = argv[++i];
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch.transcriptDir = argv[++i];
+        } else if (arg == "--batch-out" && i + 1 < argc) {
+            batch.outputDir = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc) {
+            long long seed = std::atoll(argv[++i]);
+            interpreter.seedRandom(static_cast<uint64_t>(seed));
+            batch.seed = static_cast<unsigned int>(seed);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            batch.threads = std::atoi(argv[++i]);
+        } else if (arg == "--memory-limit" && i + 1 < argc) {
+            long long limit = std::atoll(argv[++i]);
+            if (limit <= 0) {
+                usageError = true;
+                continue;
+            }
+            interpreter.setMemoryLimit(static_cast<size_t>(limit));
+            batch.memoryLimit = static_cast<size_t>(limit);
+        } else if (arg == "--memory-report") {
+            interpreter.setMemoryReport(std::cerr);
+        } else if (arg == "--single") {
+            interpreter.setSinglePrecision(true);
+            batch.singlePrecision = true;
+        } else if (arg == "--no-hoist") {
+            interpreter.setLoopHoisting(false);
+            batch.loopHoisting = false;
+        } else if (programFile == nullptr) {
+            programFile = argv[i];
+        } else {
+            usageError = true;
+        }
+    }
 
-    if (argc > 1) {
+    if (usageError || (!batch.transcriptDir.empty() && programFile == nullptr)) {
+        std::cerr << "USAGE: " << argv[0] << " [--seed N] [--single] [--no-hoist] [--memory-limit BYTES] [--memory-report] [--spill-after SECONDS] [--spill-dir DIR] [program.bas]" << std::endl;
+        std::cerr << "       " << argv[0] << " --batch TRANSCRIPT_DIR [--batch-out DIR] [--threads N] [--seed N] [--single] [--no-hoist] [--memory-limit BYTES] program.bas" << std::endl;
+        return 1;
+    }
+
+    if (spillAfter > 0) {
+        interpreter.setIdleSpill(spillAfter, spillDir);
+    }
+
+    if (!batch.transcriptDir.empty()) {
+        // Parse the program once; load errors go to stderr so stdout stays valid JSONL
+        std::ifstream file(programFile);
+        if (!file) {
+            std::cerr << "CAN'T OPEN " << programFile << std::endl;
+            return 1;
+        }
+        interpreter.setStreams(std::cin, std::cerr);
+        std::string line;
+        while (std::getline(file, line)) {
+            interpreter.processLine(line);
+        }
+        return runBatch(interpreter, batch);
+    }
+
+    if (programFile) {
         // File mode
-        std::ifstream file(argv[1]);
+        std::ifstream file(programFile);
         if (!file) {
-            std::cerr << "CAN'T OPEN " << argv[1] << std::endl;
+            std::cerr << "CAN'T OPEN " << programFile << std::endl;
             return 1;
         }
         std::string line;
@@ -113,14 +184,19 @@ int main(int argc, char* argv[]) {
 	std::cout << "Altair Ego: Emulating Altair BASIC 32K Rev. 3.2" << std::endl;
         std::cout << "OK" << std::endl;
 
+        // INPUT hands control back to this loop instead of blocking inside the interpreter
+        interpreter.setNonBlockingInput(true);
+
         std::string line;
         while (true) {
-            std::cout << "";
+            if (interpreter.isAwaitingInput()) {
+                interpreter.waitForTerminalInput();
+            }
             if (!std::getline(std::cin, line)) {
                 break;
             }
 
-            if (line.empty()) {
+            if (line.empty() && !interpreter.isAwaitingInput()) {
                 continue;
             }
 
@@ -130,6 +206,7 @@ int main(int argc, char* argv[]) {
                 std::cout << e.what() << std::endl;
             }
         }
+        interpreter.closeInput();
     }
     
     return 0;
@@ -0,0 +1,154 @@
+#include "matrix.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Rows and columns of the product worked on at a time, so the parts of the
+// operands in use stay in cache for large matrices
+const int BLOCK = 64;
+
+void requireSameShape(const Matrix& a, const Matrix& b) {
+    if (a.rows != b.rows || a.cols != b.cols) {
+        throw std::runtime_error("DIMENSION MISMATCH");
+    }
+}
+
+} // namespace
+
+Matrix matrixSum(const Matrix& a, const Matrix& b) {
+    requireSameShape(a, b);
+    Matrix result(a.rows, a.cols, a.vector);
+    const double* x = a.data.data();
+    const double* y = b.data.data();
+    double* r = result.data.data();
+    for (size_t i = 0, n = result.data.size(); i < n; i++) {
+        r[i] = x[i] + y[i];
+    }
+    return result;
+}
+
+Matrix matrixDifference(const Matrix& a, const Matrix& b) {
+    requireSameShape(a, b);
+    Matrix result(a.rows, a.cols, a.vector);
+    const double* x = a.data.data();
+    const double* y = b.data.data();
+    double* r = result.data.data();
+    for (size_t i = 0, n = result.data.size(); i < n; i++) {
+        r[i] = x[i] - y[i];
+    }
+    return result;
+}
+
+Matrix matrixScale(double k, const Matrix& a) {
+    Matrix result(a.rows, a.cols, a.vector);
+    const double* x = a.data.data();
+    double* r = result.data.data();
+    for (size_t i = 0, n = result.data.size(); i < n; i++) {
+        r[i] = k * x[i];
+    }
+    return result;
+}
+
+// i-k-j order over blocks: the inner loop runs along a row of b and of the
+// result. Each element still sums its terms in order of k, so the result
+// doesn't depend on the block size.
+Matrix matrixProduct(const Matrix& a, const Matrix& b) {
+    if (a.cols != b.rows) {
+        throw std::runtime_error("DIMENSION MISMATCH");
+    }
+    Matrix result(a.rows, b.cols, b.vector);
+    for (int ii = 0; ii < a.rows; ii += BLOCK) {
+        int iEnd = std::min(ii + BLOCK, a.rows);
+        for (int kk = 0; kk < a.cols; kk += BLOCK) {
+            int kEnd = std::min(kk + BLOCK, a.cols);
+            for (int jj = 0; jj < b.cols; jj += BLOCK) {
+                int jEnd = std::min(jj + BLOCK, b.cols);
+                for (int i = ii; i < iEnd; i++) {
+                    double* r = &result.at(i, 0);
+                    for (int k = kk; k < kEnd; k++) {
+                        double aik = a.at(i, k);
+                        const double* y = &b.data[static_cast<size_t>(k) * b.cols];
+                        for (int j = jj; j < jEnd; j++) {
+                            r[j] += aik * y[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+Matrix matrixTranspose(const Matrix& a) {
+    Matrix result(a.cols, a.rows);
+    for (int ii = 0; ii < a.rows; ii += BLOCK) {
+        int iEnd = std::min(ii + BLOCK, a.rows);
+        for (int jj = 0; jj < a.cols; jj += BLOCK) {
+            int jEnd = std::min(jj + BLOCK, a.cols);
+            for (int i = ii; i < iEnd; i++) {
+                for (int j = jj; j < jEnd; j++) {
+                    result.at(j, i) = a.at(i, j);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+Matrix matrixIdentity(int n) {
+    Matrix result(n, n);
+    for (int i = 0; i < n; i++) {
+        result.at(i, i) = 1.0;
+    }
+    return result;
+}
+
+Matrix matrixInverse(const Matrix& a) {
+    if (a.rows != a.cols || a.vector) {
+        throw std::runtime_error("DIMENSION MISMATCH");
+    }
+    int n = a.rows;
+    Matrix work = a;
+    Matrix result = matrixIdentity(n);
+
+    for (int column = 0; column < n; column++) {
+        // The largest remaining entry in the column keeps rounding error down
+        int pivot = column;
+        for (int row = column + 1; row < n; row++) {
+            if (std::fabs(work.at(row, column)) > std::fabs(work.at(pivot, column))) {
+                pivot = row;
+            }
+        }
+        if (work.at(pivot, column) == 0.0) {
+            throw std::runtime_error("DIVISION BY ZERO");
+        }
+        if (pivot != column) {
+            std::swap_ranges(&work.at(pivot, 0), &work.at(pivot, 0) + n, &work.at(column, 0));
+            std::swap_ranges(&result.at(pivot, 0), &result.at(pivot, 0) + n, &result.at(column, 0));
+        }
+
+        double scale = 1.0 / work.at(column, column);
+        double* w = &work.at(column, 0);
+        double* r = &result.at(column, 0);
+        for (int j = 0; j < n; j++) {
+            w[j] *= scale;
+            r[j] *= scale;
+        }
+
+        for (int row = 0; row < n; row++) {
+            double factor = work.at(row, column);
+            if (row == column || factor == 0.0) {
+                continue;
+            }
+            double* wRow = &work.at(row, 0);
+            double* rRow = &result.at(row, 0);
+            for (int j = 0; j < n; j++) {
+                wRow[j] -= factor * w[j];
+                rRow[j] -= factor * r[j];
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,37 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <cstddef>
+#include <vector>
+
+// The working form of a MAT operand: elements 1..rows by 1..cols of a BASIC
+// array, copied into contiguous row-major doubles so the kernels below are
+// plain loops the compiler can vectorize. A vector (a one-dimensional array)
+// is a matrix with one column that is stored back as a one-dimensional array.
+struct Matrix {
+    int rows;
+    int cols;
+    bool vector;
+    std::vector<double> data;
+
+    Matrix(int r, int c, bool isVector = false) : rows(r), cols(c), vector(isVector), data(static_cast<size_t>(r) * c, 0.0) {}
+
+    double& at(int i, int j) { return data[static_cast<size_t>(i) * cols + j]; }
+    double at(int i, int j) const { return data[static_cast<size_t>(i) * cols + j]; }
+};
+
+// Kernels of the MAT statements. Each returns a new matrix, so a target that
+// is also an operand is never overwritten while it is being read. Operands of
+// the wrong shape raise DIMENSION MISMATCH.
+Matrix matrixSum(const Matrix& a, const Matrix& b);
+Matrix matrixDifference(const Matrix& a, const Matrix& b);
+Matrix matrixScale(double k, const Matrix& a);
+Matrix matrixProduct(const Matrix& a, const Matrix& b);
+Matrix matrixTranspose(const Matrix& a);
+Matrix matrixIdentity(int n);
+
+// Gauss-Jordan elimination with partial pivoting; a singular matrix raises
+// DIVISION BY ZERO
+Matrix matrixInverse(const Matrix& a);
+
+#endif
@@ -0,0 +1,198 @@
+#include "optimize.h"
+#include "functions.h"
+#include "print.h"
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Stores the value of a numeric literal in its node, so it is read from the
+// text only once. A literal that can't be decoded keeps its string marker
+// and raises its error when evaluated.
+void decode(ASTNode& literal, double (*narrow)(double)) {
+    try {
+        double value = std::stod(literal.value);
+        literal.text = Value(narrow ? narrow(value) : value);
+    } catch (const std::exception&) {
+    }
+}
+
+bool isConstant(const ASTNode& node) {
+    return node.type == NODE_NUMBER && !node.text.isString();
+}
+
+std::shared_ptr<ASTNode> numberNode(double value) {
+    // 17 significant digits read back as exactly the same double
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    auto number = std::make_shared<ASTNode>(NODE_NUMBER, text);
+    number->text = Value(value);
+    return number;
+}
+
+// Built-in functions whose result depends only on their arguments
+bool isPureFunction(const std::string& name) {
+    return name != "RND" && name != "FRE" && name != "TAB" && name != "USR";
+}
+
+// Computes the value of a constant expression: literals combined by operators
+// or passed to pure built-in functions. Returns false if expr isn't constant;
+// throws if evaluating it raises an error.
+bool constantValue(const ASTNode& expr, double (*narrow)(double), double& result) {
+    switch (expr.type) {
+        case NODE_UNARY_OP:
+            if (expr.children.size() != 1 || !isConstant(*expr.children[0])) {
+                return false;
+            }
+            if (expr.operator_type == OP_MINUS) {
+                result = -expr.children[0]->text.number();
+                return true;
+            } else if (expr.value == "NOT") {
+                result = expr.children[0]->text.number() == 0.0 ? -1.0 : 0.0;
+                return true;
+            }
+            return false;
+
+        case NODE_BINARY_OP:
+            if (expr.operator_type == OP_ASSIGN || expr.children.size() != 2 ||
+                !isConstant(*expr.children[0]) || !isConstant(*expr.children[1])) {
+                return false;
+            }
+            result = MathFunctions::operate(expr.operator_type, expr.children[0]->text.number(), expr.children[1]->text.number());
+            break;
+
+        case NODE_FUNCTION_CALL:
+            if (!isPureFunction(expr.value)) {
+                return false;
+            }
+            if (expr.value == "LEN" || expr.value == "ASC" || expr.value == "VAL") {
+                if (expr.children.size() != 1 || expr.children[0]->type != NODE_STRING) {
+                    return false;
+                }
+                StringView s = expr.children[0]->text.text();
+                if (expr.value == "LEN") {
+                    result = MathFunctions::len(s);
+                    return true;
+                } else if (expr.value == "ASC") {
+                    result = MathFunctions::asc(s);
+                    return true;
+                }
+                result = MathFunctions::val(s);
+            } else {
+                std::vector<double> args;
+                for (const auto& arg : expr.children) {
+                    if (!isConstant(*arg)) {
+                        return false;
+                    }
+                    args.push_back(arg->text.number());
+                }
+                result = MathFunctions::callFunction(expr.value, args);
+            }
+            break;
+
+        default:
+            return false;
+    }
+    if (narrow) {
+        result = narrow(result);
+    }
+    return true;
+}
+
+// A literal node for the value of expr, or null if it isn't constant
+std::shared_ptr<ASTNode> fold(const ASTNode& expr, double (*narrow)(double)) {
+    double value;
+    try {
+        if (constantValue(expr, narrow, value)) {
+            return numberNode(value);
+        }
+    } catch (const std::exception&) {
+        // DIVISION BY ZERO, OVERFLOW and the like are raised at run time
+    }
+    return nullptr;
+}
+
+// The reciprocal of divisor if multiplying by it gives exactly the same
+// results as dividing, which is the case for powers of two
+bool exactReciprocal(double divisor, double& reciprocal, double (*narrow)(double)) {
+    int exponent;
+    if (!std::isnormal(divisor) || std::fabs(std::frexp(divisor, &exponent)) != 0.5) {
+        return false;
+    }
+    reciprocal = 1.0 / divisor;
+    if (!std::isnormal(reciprocal)) {
+        return false;
+    }
+    try {
+        return !narrow || narrow(reciprocal) == reciprocal;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Rewrites ^ and / whose right operand is a literal
+void strengthReduce(ASTNode& expr, double (*narrow)(double)) {
+    if (expr.type != NODE_BINARY_OP || expr.children.size() != 2 || !isConstant(*expr.children[1])) {
+        return;
+    }
+    double constant = expr.children[1]->text.number();
+
+    if (expr.operator_type == OP_POWER) {
+        if (constant == 2) {
+            expr.operator_type = OP_SQUARE;
+        } else if (constant == 3) {
+            expr.operator_type = OP_CUBE;
+        } else if (constant == 4) {
+            expr.operator_type = OP_FOURTH_POWER;
+        } else if (constant == 0.5) {
+            expr.operator_type = OP_SQUARE_ROOT;
+        }
+    } else if (expr.operator_type == OP_DIVIDE && constant != 0) {
+        double reciprocal;
+        if (exactReciprocal(constant, reciprocal, narrow)) {
+            expr.operator_type = OP_MULTIPLY;
+            expr.children[1] = numberNode(reciprocal);
+        } else {
+            expr.operator_type = OP_DIVIDE_NONZERO;
+        }
+    }
+}
+
+void optimize(std::shared_ptr<ASTNode>& node, double (*narrow)(double)) {
+    if (node->type == NODE_NUMBER) {
+        decode(*node, narrow);
+        return;
+    }
+    for (auto& child : node->children) {
+        optimize(child, narrow);
+    }
+
+    if (node->type == NODE_STATEMENT) {
+        if (node->keyword == KW_PRINT) {
+            node->plan = compilePrint(*node);
+        }
+        return;
+    }
+    
+    auto folded = fold(*node, narrow);
+    if (folded) {
+        node = folded;
+    } else {
+        strengthReduce(*node, narrow);
+    }
+}
+
+} // namespace
+
+void optimizeLine(ASTNode& line, double (*narrow)(double)) {
+    for (auto& stmt : line.children) {
+        // DATA items are text until they are READ
+        if (stmt->type == NODE_STATEMENT && stmt->keyword == KW_DATA) {
+            continue;
+        }
+        optimize(stmt, narrow);
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include "parser.h"
+
+// Load-time rewrites of a parsed line's expressions, done before the line is
+// stored or run. Numeric literals are decoded into their node's text, so they
+// are never parsed again. Operators and pure built-in functions applied to
+// literals are folded into a single literal, and ^ or / with a constant right
+// operand becomes a cheaper operator (OP_SQUARE, OP_DIVIDE_NONZERO, ...).
+// Anything that would raise an error is left for run time, so errors are still
+// reported where they happen.
+//
+// narrow, if not null, rounds each folded result the way the interpreter
+// rounds computed numbers (single-precision mode).
+void optimizeLine(ASTNode& line, double (*narrow)(double));
+
+#endif
@@ -163,6 +163,10 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
         return parseDimStatement();
     } else if (matchKeyword(KW_DEF)) {
         return parseDefStatement();
+    } else if (matchKeyword(KW_RANDOMIZE)) {
+        return parseRandomizeStatement();
+    } else if (matchKeyword(KW_MAT)) {
+        return parseMatStatement();
     } else if (match(TOKEN_VARIABLE)) {
         // Implicit LET statement
         return parseLetStatement();
@@ -448,6 +452,7 @@ std::shared_ptr<ASTNode> Parser::parseDataStatement() {
             auto data = std::make_shared<ASTNode>(
                 match(TOKEN_NUMBER) ? NODE_NUMBER : NODE_STRING,
                 getCurrentToken().value);
+            data->text = Value::intern(data->value);
             stmt->children.push_back(data);
             advance();
         }
@@ -477,6 +482,13 @@ std::shared_ptr<ASTNode> Parser::parseRestoreStatement() {
     auto stmt = std::make_shared<ASTNode>(NODE_STATEMENT);
     stmt->keyword = KW_RESTORE;
     advance(); // Skip RESTORE
+    
+    // Optional line number: RESTORE 1500
+    if (match(TOKEN_NUMBER)) {
+        auto lineNum = std::make_shared<ASTNode>(NODE_NUMBER, getCurrentToken().value);
+        stmt->children.push_back(lineNum);
+        advance();
+    }
     return stmt;
 }
 
@@ -761,6 +773,7 @@ std::shared_ptr<ASTNode> Parser::parsePrimary() {
     
     if (match(TOKEN_STRING)) {
         auto str = std::make_shared<ASTNode>(NODE_STRING, getCurrentToken().value);
+        str->text = Value::intern(str->value);
         advance();
         return str;
     }
@@ -825,6 +838,7 @@ std::shared_ptr<ASTNode> Parser::parsePrimary() {
                 // This is array access - could be A(1) or A(1,2) etc.
                 auto arrayAccess = std::make_shared<ASTNode>(NODE_ARRAY_ACCESS, var->value);
                 arrayAccess->children.push_back(var);
+                arrayAccess->slot = VariableManager::functionSlotFor(var->value);
                 
                 do {
                     auto indexExpr = parseExpression();
@@ -1008,3 +1022,137 @@ std::shared_ptr<ASTNode> Parser::parseDefStatement() {
     
     return stmt;
 }
+
+std::shared_ptr<ASTNode> Parser::parseRandomizeStatement() {
+    auto stmt = std::make_shared<ASTNode>(NODE_STATEMENT);
+    stmt->keyword = KW_RANDOMIZE;
+    advance(); // Skip RANDOMIZE
+    
+    // Optional seed: RANDOMIZE 42
+    if (!match(TOKEN_EOF) && !match(TOKEN_NEWLINE) && !(match(TOKEN_DELIMITER) && getCurrentToken().value == ":")) {
+        auto seedExpr = parseExpression();
+        stmt->children.push_back(seedExpr);
+    }
+    
+    return stmt;
+}
+
+// MAT READ A, B / MAT PRINT A; B / MAT A = <matrix expression>. The node's
+// value names the operation and its children are the arrays and expressions
+// it takes, the target first:
+//   MAT A = B            COPY   A, B
+//   MAT A = B + C        ADD    A, B, C      (SUB for -, MUL for *)
+//   MAT A = (K) * B      SCALE  A, K, B
+//   MAT A = TRN(B)       TRN    A, B         (INV likewise)
+//   MAT A = ZER(M, N)    ZER    A, M, N      (CON, IDN; the bounds are optional)
+std::shared_ptr<ASTNode> Parser::parseMatStatement() {
+    auto stmt = std::make_shared<ASTNode>(NODE_STATEMENT);
+    stmt->keyword = KW_MAT;
+    advance(); // Skip MAT
+    
+    if (matchKeyword(KW_READ)) {
+        stmt->value = "READ";
+        advance();
+        do {
+            stmt->children.push_back(parseMatrixName());
+            if (match(TOKEN_DELIMITER) && getCurrentToken().value == ",") {
+                advance();
+            } else {
+                break;
+            }
+        } while (true);
+        return stmt;
+    }
+    
+    if (matchKeyword(KW_PRINT)) {
+        stmt->value = "PRINT";
+        advance();
+        // Like PRINT, a ; after an array packs its columns and a , spaces them by zone
+        while (!match(TOKEN_EOF) && !match(TOKEN_NEWLINE) && !(match(TOKEN_DELIMITER) && getCurrentToken().value == ":")) {
+            if (match(TOKEN_DELIMITER) && (getCurrentToken().value == "," || getCurrentToken().value == ";")) {
+                stmt->children.push_back(std::make_shared<ASTNode>(NODE_STRING, getCurrentToken().value));
+                advance();
+            } else {
+                stmt->children.push_back(parseMatrixName());
+            }
+        }
+        return stmt;
+    }
+    
+    stmt->children.push_back(parseMatrixName());
+    if (!matchOperator(OP_EQUAL)) {
+        syntaxError();
+    }
+    advance(); // Skip =
+    
+    std::string name = match(TOKEN_VARIABLE) ? getCurrentToken().value : "";
+    if (name == "C" && peekToken().type == TOKEN_KEYWORD && peekToken().keyword == KW_ON) {
+        // CON reads as C followed by the keyword ON
+        advance();
+        name = "CON";
+    }
+    
+    if (name == "ZER" || name == "CON" || name == "IDN") {
+        stmt->value = name;
+        advance();
+        if (match(TOKEN_DELIMITER) && getCurrentToken().value == "(") {
+            advance(); // Skip (
+            do {
+                stmt->children.push_back(parseExpression());
+                if (match(TOKEN_DELIMITER) && getCurrentToken().value == ",") {
+                    advance();
+                } else {
+                    break;
+                }
+            } while (true);
+            if (!match(TOKEN_DELIMITER) || getCurrentToken().value != ")") {
+                syntaxError();
+            }
+            advance(); // Skip )
+        }
+    } else if (name == "TRN" || name == "INV") {
+        stmt->value = name;
+        advance();
+        if (!match(TOKEN_DELIMITER) || getCurrentToken().value != "(") {
+            syntaxError();
+        }
+        advance(); // Skip (
+        stmt->children.push_back(parseMatrixName());
+        if (!match(TOKEN_DELIMITER) || getCurrentToken().value != ")") {
+            syntaxError();
+        }
+        advance(); // Skip )
+    } else if (match(TOKEN_DELIMITER) && getCurrentToken().value == "(") {
+        stmt->value = "SCALE";
+        advance(); // Skip (
+        stmt->children.push_back(parseExpression());
+        if (!match(TOKEN_DELIMITER) || getCurrentToken().value != ")") {
+            syntaxError();
+        }
+        advance(); // Skip )
+        if (!matchOperator(OP_MULTIPLY)) {
+            syntaxError();
+        }
+        advance(); // Skip *
+        stmt->children.push_back(parseMatrixName());
+    } else {
+        stmt->value = "COPY";
+        stmt->children.push_back(parseMatrixName());
+        if (matchOperator(OP_PLUS) || matchOperator(OP_MINUS) || matchOperator(OP_MULTIPLY)) {
+            stmt->value = matchOperator(OP_PLUS) ? "ADD" : matchOperator(OP_MINUS) ? "SUB" : "MUL";
+            advance();
+            stmt->children.push_back(parseMatrixName());
+        }
+    }
+    
+    return stmt;
+}
+
+std::shared_ptr<ASTNode> Parser::parseMatrixName() {
+    if (!match(TOKEN_VARIABLE)) {
+        syntaxError();
+    }
+    auto name = std::make_shared<ASTNode>(NODE_VARIABLE, getCurrentToken().value);
+    advance();
+    return name;
+}
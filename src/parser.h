@@ -2,6 +2,7 @@
 #define PARSER_H
 
 #include "lexer.h"
+#include "variable.h"
 #include <vector>
 #include <memory>
 
@@ -20,9 +21,12 @@ enum NodeType {
     NODE_STRING_FUNCTION_CALL,
     NODE_ARRAY_ACCESS,
     NODE_DIM_DECLARATION,
-    NODE_ON_ERROR_GOTO
+    NODE_ON_ERROR_GOTO,
+    NODE_PARAMETER      // The parameter inside a compiled DEF FN body
 };
 
+struct PrintPlan;
+
 struct ASTNode {
     NodeType type;
     std::string value;
@@ -30,11 +34,31 @@ struct ASTNode {
     KeywordType keyword;
     OperatorType operator_type;
     int line_number;
+    Value text;         // Interned value of string literals and DATA items, decoded value of
+                        // numeric literals (a string until optimizeLine decodes it)
+    int slot;           // Variable slot of NODE_VARIABLE names, function slot of FN calls, -1 otherwise
+    int hoistSlot;      // Loop-invariant value cache entry, -1 if not hoisted (see hoist.h)
+    bool integral;      // Integer-valued operator node, evaluated with integers (see integer.h)
+    int jumpLine;       // Resolved target of a GOTO or GOSUB statement, -1 if not resolved (see jump.h)
+    bool jumpCrossesNext;   // A NEXT lies between a resolved jump and its target
+    std::shared_ptr<const PrintPlan> plan;  // Compiled form of a PRINT statement (see print.h)
     
     ASTNode(NodeType t = NODE_EXPRESSION, const std::string& v = "") 
-        : type(t), value(v), keyword(KW_PRINT), operator_type(OP_PLUS), line_number(0) {}
+        : type(t), value(v), keyword(KW_PRINT), operator_type(OP_PLUS), line_number(0),
+          text(t == NODE_NUMBER ? Value::emptyString() : Value()),
+          slot(t == NODE_VARIABLE ? VariableManager::slotFor(v) : -1), hoistSlot(-1), integral(false),
+          jumpLine(-1), jumpCrossesNext(false) {}
 };
 
+// Whether an expression is a string by its form: a string literal, string
+// variable or array element, or a string function
+inline bool isStringOperand(const ASTNode& node) {
+    return node.type == NODE_STRING ||
+           (node.type == NODE_VARIABLE && node.value.back() == '$') ||
+           node.type == NODE_STRING_FUNCTION_CALL ||
+           (node.type == NODE_ARRAY_ACCESS && node.children.size() >= 2 && node.children[0]->value.back() == '$');
+}
+
 class Parser {
 private:
     std::vector<Token> tokens;
@@ -86,6 +110,9 @@ private:
     std::shared_ptr<ASTNode> parseClearStatement();
     std::shared_ptr<ASTNode> parseDimStatement();
     std::shared_ptr<ASTNode> parseDefStatement();
+    std::shared_ptr<ASTNode> parseRandomizeStatement();
+    std::shared_ptr<ASTNode> parseMatStatement();
+    std::shared_ptr<ASTNode> parseMatrixName();
     
 public:
     Parser();
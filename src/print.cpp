@@ -0,0 +1,40 @@
+#include "print.h"
+
+namespace {
+
+// The parser stores separators as "," and ";" NODE_STRINGs. A literal "," or
+// ";" has always been taken for one too.
+bool isSeparator(const ASTNode& node, const char* separator) {
+    return node.type == NODE_STRING && node.value == separator;
+}
+
+} // namespace
+
+std::shared_ptr<const PrintPlan> compilePrint(const ASTNode& stmt) {
+    auto plan = std::make_shared<PrintPlan>();
+    bool hasContent = false;
+    
+    for (const auto& child : stmt.children) {
+        if (isSeparator(*child, ",")) {
+            plan->items.emplace_back(PrintItem::ZONE, Value(), nullptr);
+        } else if (isSeparator(*child, ";")) {
+            // Only means something at the end of the statement
+        } else if (child->type == NODE_FUNCTION_CALL && child->value == "TAB") {
+            // TAB() with no argument doesn't move
+            if (!child->children.empty()) {
+                plan->items.emplace_back(PrintItem::TAB, Value(), child->children[0]);
+            }
+        } else if (child->type == NODE_STRING) {
+            plan->items.emplace_back(PrintItem::TEXT, child->text, nullptr);
+            hasContent = true;
+        } else {
+            plan->items.emplace_back(isStringOperand(*child) ? PrintItem::STRING : PrintItem::VALUE, Value(), child);
+            hasContent = true;
+        }
+    }
+    
+    // A bare PRINT ends the line
+    plan->newline = stmt.children.empty() ||
+                    (hasContent && !isSeparator(*stmt.children.back(), ";"));
+    return plan;
+}
@@ -0,0 +1,34 @@
+#ifndef PRINT_H
+#define PRINT_H
+
+#include "parser.h"
+#include <memory>
+#include <vector>
+
+// A PRINT statement compiled into the steps that produce its output. The
+// separators, literal text and TAB calls are sorted out once, when the line
+// is entered, so running the statement only evaluates its expressions.
+struct PrintItem {
+    enum Kind {
+        TEXT,       // A string literal, printed as is
+        ZONE,       // A comma: move to the next 14-column print zone
+        TAB,        // TAB(expr): move forward to a column
+        STRING,     // An expression known to give a string
+        VALUE       // An expression printed as whatever it turns out to be
+    };
+    
+    Kind kind;
+    Value text;                     // TEXT
+    std::shared_ptr<ASTNode> expr;  // TAB column, STRING or VALUE expression
+    
+    PrintItem(Kind k, const Value& t, const std::shared_ptr<ASTNode>& e) : kind(k), text(t), expr(e) {}
+};
+
+struct PrintPlan {
+    std::vector<PrintItem> items;
+    bool newline;   // False after a trailing ; or if only TABs and separators are printed
+};
+
+std::shared_ptr<const PrintPlan> compilePrint(const ASTNode& stmt);
+
+#endif
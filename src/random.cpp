@@ -0,0 +1,97 @@
+#include "random.h"
+#include "spill.h"
+#include <cstring>
+#include <random>
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+RandomGenerator::RandomGenerator() : position(BUFFER_SIZE), lastRandom(0.0) {
+    seedFromDevice();
+}
+
+void RandomGenerator::seed(uint64_t value) {
+    // Expand the seed with splitmix64 so that small seeds still give a well mixed state
+    for (uint64_t& word : state) {
+        value += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = value;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        word = z ^ (z >> 31);
+    }
+    position = BUFFER_SIZE;
+    lastRandom = 0.0;
+}
+
+void RandomGenerator::seedFromDevice() {
+    std::random_device rd;
+    seed((static_cast<uint64_t>(rd()) << 32) | rd());
+}
+
+void RandomGenerator::seedFromNumber(double value) {
+    // Converting a double outside the integer type's range is undefined, so
+    // only values inside [-2^63, 2^64) are cast
+    if (value >= -0x1.0p63 && value < 0x1.0p64) {
+        seed(value < 0 ? static_cast<uint64_t>(static_cast<int64_t>(value)) : static_cast<uint64_t>(value));
+        return;
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    seed(bits);
+}
+
+uint64_t RandomGenerator::nextBits() {
+    uint64_t result = rotl(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+}
+
+void RandomGenerator::refill() {
+    for (size_t i = 0; i < BUFFER_SIZE; i++) {
+        // Top 53 bits give every representable double in [0, 1) with equal spacing
+        buffer[i] = static_cast<double>(nextBits() >> 11) * 0x1.0p-53;
+    }
+    position = 0;
+}
+
+double RandomGenerator::rnd(double x) {
+    if (x > 0) {
+        return next();
+    } else if (x == 0) {
+        return lastRandom;
+    }
+    seedFromNumber(-x);
+    return next();
+}
+
+void RandomGenerator::save(SpillWriter& out) const {
+    for (uint64_t word : state) {
+        out.putInt(static_cast<int64_t>(word));
+    }
+    out.putInt(position);
+    for (size_t i = position; i < BUFFER_SIZE; i++) {
+        out.putDouble(buffer[i]);
+    }
+    out.putDouble(lastRandom);
+}
+
+void RandomGenerator::load(SpillReader& in) {
+    for (uint64_t& word : state) {
+        word = static_cast<uint64_t>(in.getInt());
+    }
+    position = static_cast<size_t>(in.getInt());
+    if (position > BUFFER_SIZE) {
+        position = BUFFER_SIZE;
+    }
+    for (size_t i = position; i < BUFFER_SIZE; i++) {
+        buffer[i] = in.getDouble();
+    }
+    lastRandom = in.getDouble();
+}
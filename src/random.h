@@ -0,0 +1,50 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <cstddef>
+
+class SpillWriter;
+class SpillReader;
+
+// xoshiro256** generator owned by each interpreter. Numbers are produced a
+// block at a time so RND in an inner loop is a buffer read.
+class RandomGenerator {
+private:
+    static const size_t BUFFER_SIZE = 64;
+
+    uint64_t state[4];
+    double buffer[BUFFER_SIZE];
+    size_t position;
+    double lastRandom;
+
+    uint64_t nextBits();
+    void refill();
+
+public:
+    RandomGenerator();
+    void seed(uint64_t value);
+    void seedFromDevice();
+
+    // Seeds from a BASIC number: its integer part when that fits in 64 bits,
+    // otherwise (huge, infinite or NaN) its bit pattern
+    void seedFromNumber(double value);
+
+    // Uniform in [0, 1)
+    double next() {
+        if (position == BUFFER_SIZE) {
+            refill();
+        }
+        lastRandom = buffer[position++];
+        return lastRandom;
+    }
+
+    // RND(x): x > 0 next number, x = 0 repeat last, x < 0 reseed with -x
+    double rnd(double x);
+    double last() const { return lastRandom; }
+
+    void save(SpillWriter& out) const;
+    void load(SpillReader& in);
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "spill.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#include <zlib.h>
+#define SPILL_COMPRESSED 1
+#endif
+
+static const char SPILL_MAGIC[8] = {'A', 'E', 'G', 'O', 'S', 'P', 'L', '1'};
+
+void SpillWriter::putInt(int64_t value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void SpillWriter::putDouble(double value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void SpillWriter::putString(const std::string& value) {
+    putInt(static_cast<int64_t>(value.size()));
+    buffer.append(value);
+}
+
+SpillReader::SpillReader(const std::string& data) : buffer(data), position(0) {}
+
+void SpillReader::read(void* out, size_t size) {
+    if (position + size > buffer.size()) {
+        throw std::runtime_error("BAD SPILL FILE");
+    }
+    std::memcpy(out, buffer.data() + position, size);
+    position += size;
+}
+
+int64_t SpillReader::getInt() {
+    int64_t value;
+    read(&value, sizeof(value));
+    return value;
+}
+
+double SpillReader::getDouble() {
+    double value;
+    read(&value, sizeof(value));
+    return value;
+}
+
+std::string SpillReader::getString() {
+    int64_t size = getInt();
+    if (size < 0 || position + static_cast<size_t>(size) > buffer.size()) {
+        throw std::runtime_error("BAD SPILL FILE");
+    }
+    std::string value = buffer.substr(position, static_cast<size_t>(size));
+    position += static_cast<size_t>(size);
+    return value;
+}
+
+void writeSpillFile(const std::string& path, const std::string& data) {
+    std::string payload;
+#ifdef SPILL_COMPRESSED
+    uLongf compressedSize = compressBound(data.size());
+    payload.resize(compressedSize);
+    if (compress2(reinterpret_cast<Bytef*>(&payload[0]), &compressedSize,
+                  reinterpret_cast<const Bytef*>(data.data()), data.size(), Z_BEST_SPEED) != Z_OK) {
+        throw std::runtime_error("SPILL FAILED");
+    }
+    payload.resize(compressedSize);
+#else
+    payload = data;
+#endif
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("CAN'T OPEN " + path);
+    }
+    uint64_t originalSize = data.size();
+    file.write(SPILL_MAGIC, sizeof(SPILL_MAGIC));
+    file.write(reinterpret_cast<const char*>(&originalSize), sizeof(originalSize));
+    file.write(payload.data(), payload.size());
+    if (!file) {
+        throw std::runtime_error("SPILL FAILED");
+    }
+}
+
+std::string readSpillFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("CAN'T OPEN " + path);
+    }
+    char magic[sizeof(SPILL_MAGIC)];
+    uint64_t originalSize = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&originalSize), sizeof(originalSize));
+    if (!file || std::memcmp(magic, SPILL_MAGIC, sizeof(SPILL_MAGIC)) != 0) {
+        throw std::runtime_error("BAD SPILL FILE");
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string payload = contents.str();
+
+#ifdef SPILL_COMPRESSED
+    std::string data(originalSize, '\0');
+    uLongf size = originalSize;
+    if (originalSize > 0 &&
+        uncompress(reinterpret_cast<Bytef*>(&data[0]), &size,
+                   reinterpret_cast<const Bytef*>(payload.data()), payload.size()) != Z_OK) {
+        throw std::runtime_error("BAD SPILL FILE");
+    }
+    return data;
+#else
+    if (payload.size() != originalSize) {
+        throw std::runtime_error("BAD SPILL FILE");
+    }
+    return payload;
+#endif
+}
@@ -0,0 +1,38 @@
+#ifndef SPILL_H
+#define SPILL_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Flat binary encoding of interpreter state for session spill files.
+class SpillWriter {
+private:
+    std::string buffer;
+
+public:
+    void putInt(int64_t value);
+    void putDouble(double value);
+    void putString(const std::string& value);
+    const std::string& data() const { return buffer; }
+};
+
+class SpillReader {
+private:
+    std::string buffer;
+    size_t position;
+
+    void read(void* out, size_t size);
+
+public:
+    explicit SpillReader(const std::string& data);
+    int64_t getInt();
+    double getDouble();
+    std::string getString();
+};
+
+// Spill files are deflate-compressed when zlib is available at build time.
+void writeSpillFile(const std::string& path, const std::string& data);
+std::string readSpillFile(const std::string& path);
+
+#endif
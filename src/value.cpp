@@ -0,0 +1,224 @@
+#include "value.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+// An interned block may be shared by interpreters on several threads, so its
+// count is changed atomically. Other blocks belong to one interpreter and use
+// plain loads and stores of the same counter.
+struct StringBlock {
+    std::atomic<size_t> refs;
+    bool interned;      // In the intern table, which a block leaves when its last reference goes
+    size_t length;
+    size_t capacity;
+    char chars[1];
+};
+
+static StringBlock* allocateBlock(size_t length, size_t capacity) {
+    void* memory = ::operator new(offsetof(StringBlock, chars) + capacity);
+    StringBlock* block = static_cast<StringBlock*>(memory);
+    new (&block->refs) std::atomic<size_t>(1);
+    block->interned = false;
+    block->length = length;
+    block->capacity = capacity;
+    return block;
+}
+
+// Literals by text. A block whose count has reached 0 is being freed and is
+// never handed out again; intern() replaces its entry instead. Allocated once
+// and never destroyed, so values released during static destruction still
+// find it.
+static std::mutex internMutex;
+static std::unordered_map<std::string, StringBlock*>& internTable() {
+    static auto* table = new std::unordered_map<std::string, StringBlock*>();
+    return *table;
+}
+
+static void releaseInterned(StringBlock* block) {
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    // No reference is left and none can be taken, so the block is ours to free
+    {
+        std::lock_guard<std::mutex> lock(internMutex);
+        auto& table = internTable();
+        auto it = table.find(std::string(block->chars, block->length));
+        if (it != table.end() && it->second == block) {
+            table.erase(it);
+        }
+    }
+    ::operator delete(block);
+}
+
+Value::Value(double number) {
+    if (std::isnan(number)) {
+        number = std::numeric_limits<double>::quiet_NaN();
+    }
+    std::memcpy(&bits, &number, sizeof(bits));
+}
+
+void Value::setBlock(StringBlock* block) {
+    if (reinterpret_cast<uintptr_t>(block) > PAYLOAD_MASK) {
+        throw std::bad_alloc(); // Pointer doesn't fit in a NaN payload
+    }
+    bits = STRING_BITS | (static_cast<uint64_t>(HEAP_TAG) << 48) | static_cast<uint64_t>(reinterpret_cast<uintptr_t>(block));
+}
+
+void Value::setInline(const char* chars, size_t length) {
+    bits = STRING_BITS | (static_cast<uint64_t>(length) << 48);
+    std::memcpy(reinterpret_cast<char*>(&bits), chars, length);
+}
+
+void Value::retain() const {
+    if (!isHeap()) {
+        return;
+    }
+    std::atomic<size_t>& refs = block()->refs;
+    if (block()->interned) {
+        refs.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        refs.store(refs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+void Value::release() {
+    if (!isHeap()) {
+        return;
+    }
+    if (block()->interned) {
+        releaseInterned(block());
+        return;
+    }
+    std::atomic<size_t>& refs = block()->refs;
+    size_t remaining = refs.load(std::memory_order_relaxed) - 1;
+    refs.store(remaining, std::memory_order_relaxed);
+    if (remaining == 0) {
+        ::operator delete(block());
+    }
+}
+
+Value& Value::operator=(const Value& other) {
+    if (this != &other) {
+        other.retain();
+        release();
+        bits = other.bits;
+    }
+    return *this;
+}
+
+Value& Value::operator=(Value&& other) noexcept {
+    if (this != &other) {
+        release();
+        bits = other.bits;
+        other.bits = 0;
+    }
+    return *this;
+}
+
+Value Value::string(StringView s) {
+    Value result;
+    if (s.size() <= INLINE_CAPACITY) {
+        result.setInline(s.data(), s.size());
+    } else {
+        StringBlock* block = allocateBlock(s.size(), s.size());
+        std::memcpy(block->chars, s.data(), s.size());
+        result.setBlock(block);
+    }
+    return result;
+}
+
+Value Value::concat(StringView left, StringView right) {
+    size_t length = left.size() + right.size();
+    Value result;
+    if (length <= INLINE_CAPACITY) {
+        char chars[INLINE_CAPACITY];
+        std::memcpy(chars, left.data(), left.size());
+        std::memcpy(chars + left.size(), right.data(), right.size());
+        result.setInline(chars, length);
+    } else {
+        StringBlock* block = allocateBlock(length, length);
+        std::memcpy(block->chars, left.data(), left.size());
+        std::memcpy(block->chars + left.size(), right.data(), right.size());
+        result.setBlock(block);
+    }
+    return result;
+}
+
+Value Value::intern(const std::string& s) {
+    if (s.size() <= INLINE_CAPACITY) {
+        return string(s);
+    }
+
+    std::lock_guard<std::mutex> lock(internMutex);
+    StringBlock*& shared = internTable()[s];
+    if (shared) {
+        // Take a reference unless the last one has just gone
+        size_t refs = shared->refs.load(std::memory_order_relaxed);
+        while (refs != 0 && !shared->refs.compare_exchange_weak(refs, refs + 1, std::memory_order_relaxed)) {
+        }
+        if (refs != 0) {
+            Value result;
+            result.setBlock(shared);
+            return result;
+        }
+    }
+    StringBlock* block = allocateBlock(s.size(), s.size());
+    std::memcpy(block->chars, s.data(), s.size());
+    block->interned = true;
+    shared = block;
+
+    Value result;
+    result.setBlock(block);
+    return result;
+}
+
+StringView Value::text() const {
+    if (tag() == HEAP_TAG) {
+        return StringView(block()->chars, block()->length);
+    }
+    return StringView(reinterpret_cast<const char*>(&bits), tag());
+}
+
+size_t Value::heapBytes() const {
+    if (!isHeap() || block()->interned) {
+        return 0;
+    }
+    return offsetof(StringBlock, chars) + block()->capacity;
+}
+
+size_t Value::blockBytes() const {
+    return isHeap() ? offsetof(StringBlock, chars) + block()->capacity : 0;
+}
+
+void Value::append(StringView tail) {
+    StringView current = text();
+    size_t length = current.size();
+    size_t extra = tail.size();
+    size_t total = length + extra;
+    if (extra == 0) {
+        return;
+    }
+
+    if (!isHeap() && total <= INLINE_CAPACITY) {
+        char chars[INLINE_CAPACITY];
+        std::memcpy(chars, current.data(), length);
+        std::memcpy(chars + length, tail.data(), extra);
+        setInline(chars, total);
+        return;
+    }
+    if (isHeap() && !block()->interned && block()->refs.load(std::memory_order_relaxed) == 1 && total <= block()->capacity) {
+        std::memcpy(block()->chars + length, tail.data(), extra);
+        block()->length = total;
+        return;
+    }
+
+    StringBlock* grown = allocateBlock(total, std::max(total, 2 * length));
+    std::memcpy(grown->chars, current.data(), length);
+    std::memcpy(grown->chars + length, tail.data(), extra);
+    release();
+    setBlock(grown);
+}
@@ -0,0 +1,140 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Value keeps short strings in the low bytes of a NaN and needs a little-endian target"
+#endif
+
+struct StringBlock;
+
+// Non-owning reference to the characters of a string Value or literal. Only
+// valid while the value it was taken from is neither modified nor destroyed.
+class StringView {
+private:
+    const char* chars;
+    size_t length;
+
+public:
+    StringView() : chars(""), length(0) {}
+    StringView(const char* c, size_t n) : chars(c), length(n) {}
+
+    const char* data() const { return chars; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    char operator[](size_t i) const { return chars[i]; }
+    std::string str() const { return std::string(chars, length); }
+
+    // Characters [start, start + count) of this view, clamped to its length
+    StringView substr(size_t start, size_t count) const {
+        if (start >= length) {
+            return StringView();
+        }
+        return StringView(chars + start, count < length - start ? count : length - start);
+    }
+
+    // Byte-wise ordering, the same as std::string::compare
+    int compare(StringView other) const {
+        size_t common = length < other.length ? length : other.length;
+        int result = chars == other.chars ? 0 : std::memcmp(chars, other.chars, common);
+        if (result != 0) {
+            return result;
+        }
+        return length < other.length ? -1 : (length > other.length ? 1 : 0);
+    }
+};
+
+// Views of the same storage compare equal without looking at the characters
+inline bool operator==(StringView a, StringView b) {
+    return a.size() == b.size() && (a.data() == b.data() || std::memcmp(a.data(), b.data(), a.size()) == 0);
+}
+inline bool operator!=(StringView a, StringView b) { return !(a == b); }
+inline bool operator<(StringView a, StringView b) { return a.compare(b) < 0; }
+inline bool operator<=(StringView a, StringView b) { return a.compare(b) <= 0; }
+inline bool operator>(StringView a, StringView b) { return a.compare(b) > 0; }
+inline bool operator>=(StringView a, StringView b) { return a.compare(b) >= 0; }
+
+inline std::ostream& operator<<(std::ostream& os, StringView s) {
+    return os.write(s.data(), s.size());
+}
+
+// A BASIC value in 8 bytes: a double, or a string packed into the payload of
+// a negative quiet NaN. Genuine NaNs are stored as the positive quiet NaN so
+// they never collide with a string.
+//
+// Strings of up to INLINE_CAPACITY characters live in the payload itself.
+// Longer ones point to a reference-counted block, so copying a value never
+// copies its characters; a block is only modified in place by append() while
+// it has a single owner. Interned blocks (program literals) may be shared
+// between interpreters on different threads: they are counted atomically,
+// leave the intern table with their last reference, and their bytes are
+// charged to the program lines that hold them. All other blocks belong to a
+// single interpreter.
+class Value {
+public:
+    static const size_t INLINE_CAPACITY = 6;
+
+private:
+    static const uint64_t STRING_BITS = 0xFFF8000000000000ULL;
+    static const uint64_t PAYLOAD_MASK = 0x0000FFFFFFFFFFFFULL;
+    static const unsigned HEAP_TAG = 7;       // Tags 0-6 are inline string lengths
+
+    uint64_t bits;
+
+    unsigned tag() const { return static_cast<unsigned>(bits >> 48) & 7; }
+    bool isHeap() const { return isString() && tag() == HEAP_TAG; }
+    StringBlock* block() const { return reinterpret_cast<StringBlock*>(static_cast<uintptr_t>(bits & PAYLOAD_MASK)); }
+    void setBlock(StringBlock* block);
+    void setInline(const char* chars, size_t length);
+    void retain() const;
+    void release();
+
+public:
+    Value() : bits(0) {}
+    explicit Value(double number);
+    Value(const Value& other) : bits(other.bits) { retain(); }
+    Value(Value&& other) noexcept : bits(other.bits) { other.bits = 0; }
+    ~Value() { release(); }
+
+    Value& operator=(const Value& other);
+    Value& operator=(Value&& other) noexcept;
+
+    static Value string(StringView s);
+    static Value string(const std::string& s) { return string(StringView(s.data(), s.size())); }
+    static Value emptyString() { return string(StringView()); }
+    static Value concat(StringView left, StringView right);
+
+    // Returns the shared copy of a literal, made if no value holds it yet
+    static Value intern(const std::string& s);
+
+    bool isString() const { return (bits & STRING_BITS) == STRING_BITS; }
+    double number() const {
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+
+    // The characters of a string value; inline strings point into this object
+    StringView text() const;
+    
+    // Heap bytes this value keeps alive; inline and interned strings cost nothing
+    size_t heapBytes() const;
+
+    // Heap bytes of the string's block, interned or not
+    size_t blockBytes() const;
+
+    // Amortized O(1) per character: spare capacity grows geometrically
+    void append(StringView tail);
+};
+
+// Strings print their characters and numbers print as plain doubles
+inline std::ostream& operator<<(std::ostream& os, const Value& v) {
+    return v.isString() ? os << v.text() : os << v.number();
+}
+
+#endif
@@ -1,329 +1,319 @@
 #include "variable.h"
+#include "spill.h"
 #include <stdexcept>
 #include <cctype>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <utility>
 
-VariableManager::VariableManager() {}
+VariableManager::VariableManager() : scalars(SLOT_COUNT), arrays(SLOT_COUNT), arrayBytes(0), stringBytes(0) {
+    clearAll();
+}
+
+int VariableManager::slotFor(const std::string& name) {
+    // In Altair BASIC variables are a letter, optionally followed by a digit and/or $
+    size_t length = name.size();
+    bool isString = length > 0 && name[length - 1] == '$';
+    if (isString) {
+        length--;
+    }
+    if (length < 1 || length > 2) {
+        return -1;
+    }
+    
+    int letter = std::toupper(static_cast<unsigned char>(name[0])) - 'A';
+    if (letter < 0 || letter >= 26) {
+        return -1;
+    }
+    int digit = 0;
+    if (length == 2) {
+        if (!std::isdigit(static_cast<unsigned char>(name[1]))) {
+            return -1;
+        }
+        digit = name[1] - '0' + 1;
+    }
+    return (isString ? NUMERIC_SLOTS : 0) + letter * 11 + digit;
+}
+
+int VariableManager::functionSlotFor(const std::string& name) {
+    if (name.size() < 3 || name.compare(0, 2, "FN") != 0) {
+        return -1;
+    }
+    int slot = slotFor(name.substr(2));
+    return slot >= 0 && !isStringSlot(slot) ? slot : -1;
+}
+
+std::string VariableManager::nameForSlot(int slot) {
+    int index = slot % NUMERIC_SLOTS;
+    std::string name(1, static_cast<char>('A' + index / 11));
+    if (index % 11 != 0) {
+        name += static_cast<char>('0' + index % 11 - 1);
+    }
+    if (isStringSlot(slot)) {
+        name += '$';
+    }
+    return name;
+}
 
 void VariableManager::setNumericVariable(const std::string& name, double value) {
-    std::string normalizedName = normalizeVariableName(name);
-    if (!isValidVariableName(normalizedName)) {
+    int slot = slotFor(name);
+    if (slot < 0) {
         throw std::runtime_error("ILLEGAL VARIABLE NAME");
     }
-    numericVariables[normalizedName] = value;
+    if (isStringSlot(slot)) {
+        throw std::runtime_error("TYPE MISMATCH");
+    }
+    scalars[slot] = Value(value);
 }
 
 double VariableManager::getNumericVariable(const std::string& name) {
-    std::string normalizedName = normalizeVariableName(name);
-    auto it = numericVariables.find(normalizedName);
-    if (it != numericVariables.end()) {
-        return it->second;
+    int slot = slotFor(name);
+    if (slot < 0 || isStringSlot(slot)) {
+        return 0.0; // Uninitialized variables default to 0
     }
-    return 0.0; // Uninitialized variables default to 0
+    return scalars[slot].number();
 }
 
-bool VariableManager::isNumericVariable(const std::string& name) {
-    std::string normalizedName = normalizeVariableName(name);
-    return numericVariables.find(normalizedName) != numericVariables.end();
+void VariableManager::setStringVariable(const std::string& name, const Value& value) {
+    int slot = slotFor(name);
+    if (slot < 0) {
+        throw std::runtime_error("ILLEGAL VARIABLE NAME");
+    }
+    if (!isStringSlot(slot) || !value.isString()) {
+        throw std::runtime_error("TYPE MISMATCH");
+    }
+    assign(scalars[slot], value);
 }
 
-bool VariableManager::hasVariable(const std::string& name) {
-    std::string normalizedName = normalizeVariableName(name);
-    return numericVariables.find(normalizedName) != numericVariables.end();
+void VariableManager::setStringVariable(const std::string& name, const std::string& value) {
+    setStringVariable(name, Value::string(value));
 }
 
-void VariableManager::setStringVariable(const std::string& name, const std::string& value) {
-    std::string normalizedName = normalizeVariableName(name);
-    if (!isValidVariableName(normalizedName)) {
-        throw std::runtime_error("ILLEGAL VARIABLE NAME");
+Value VariableManager::getStringVariable(const std::string& name) {
+    int slot = slotFor(name);
+    if (slot < 0 || !isStringSlot(slot)) {
+        return Value::emptyString(); // Uninitialized string variables default to empty string
     }
-    stringVariables[normalizedName] = value;
+    return scalars[slot];
 }
 
-std::string VariableManager::getStringVariable(const std::string& name) {
-    std::string normalizedName = normalizeVariableName(name);
-    auto it = stringVariables.find(normalizedName);
-    if (it != stringVariables.end()) {
-        return it->second;
+ArrayShape::ArrayShape(const std::vector<int>& dimensionExtents)
+    : extents(dimensionExtents), strides(dimensionExtents.size()), size(1) {
+    for (int i = static_cast<int>(extents.size()) - 1; i >= 0; i--) {
+        strides[i] = size;
+        size *= extents[i];
     }
-    return ""; // Uninitialized string variables default to empty string
 }
 
-bool VariableManager::isStringVariable(const std::string& name) {
-    std::string normalizedName = normalizeVariableName(name);
-    return stringVariables.find(normalizedName) != stringVariables.end();
+void VariableManager::assign(Value& target, Value value) {
+    stringBytes += value.heapBytes();
+    stringBytes -= target.heapBytes();
+    target = std::move(value);
 }
 
-void VariableManager::dimArray(const std::string& name, int size) {
-    std::string normalizedName = normalizeVariableName(name);
-    if (!isValidVariableName(normalizedName)) {
-        throw std::runtime_error("ILLEGAL VARIABLE NAME");
-    }
-    if (size < 0) {
-        throw std::runtime_error("ILLEGAL FUNCTION CALL");
-    }
-    
-    if (normalizedName.back() == '$') {
-        // String array
-        stringArrays[normalizedName] = std::vector<std::string>(size + 1, "");
-    } else {
-        // Numeric array
-        arrays[normalizedName] = std::vector<double>(size + 1, 0.0);
-    }
-    arrayDimensions[normalizedName] = {size + 1};
+void VariableManager::append(Value& target, StringView tail) {
+    stringBytes -= target.heapBytes();
+    target.append(tail);
+    stringBytes += target.heapBytes();
 }
 
-void VariableManager::dimArray(const std::string& name, const std::vector<int>& dimensions) {
-    std::string normalizedName = normalizeVariableName(name);
-    if (!isValidVariableName(normalizedName)) {
-        throw std::runtime_error("ILLEGAL VARIABLE NAME");
-    }
-    
-    // Calculate total size for multi-dimensional array
-    int totalSize = 1;
-    std::vector<int> adjustedDims;
+size_t VariableManager::bytesUsed() const {
+    return SLOT_COUNT * (sizeof(Value) + sizeof(ValueArray)) + arrayBytes + stringBytes;
+}
+
+size_t VariableManager::arrayBytesFor(const std::vector<int>& dimensions) {
+    // Elements are addressed with an int, so larger arrays can never be allocated
+    size_t elements = 1;
     for (int dim : dimensions) {
         if (dim < 0) {
-            throw std::runtime_error("ILLEGAL FUNCTION CALL");
+            return 0; // dimArray() reports the error
+        }
+        elements *= static_cast<size_t>(dim) + 1;
+        if (elements > static_cast<size_t>(INT_MAX)) {
+            return SIZE_MAX;
         }
-        adjustedDims.push_back(dim + 1); // BASIC arrays include 0 index
-        totalSize *= (dim + 1);
     }
-    
-    if (normalizedName.back() == '$') {
-        // String array
-        stringArrays[normalizedName] = std::vector<std::string>(totalSize, "");
-    } else {
-        // Numeric array
-        arrays[normalizedName] = std::vector<double>(totalSize, 0.0);
+    if (elements > static_cast<size_t>(ValueArray::PAGED_THRESHOLD)) {
+        // Only the page table; pages are charged as they are written
+        return (elements + ValueArray::PAGE_SIZE - 1) / ValueArray::PAGE_SIZE * sizeof(std::unique_ptr<Value[]>);
     }
-    arrayDimensions[normalizedName] = adjustedDims;
+    return elements * sizeof(Value);
 }
 
-void VariableManager::setArrayElement(const std::string& name, int index, double value) {
-    std::string normalizedName = normalizeVariableName(name);
-    auto it = arrays.find(normalizedName);
-    if (it == arrays.end()) {
-        // Auto-dimension with default size 10
-        dimArray(normalizedName, 10);
-        it = arrays.find(normalizedName);
-    }
-    
-    if (index < 0 || index >= static_cast<int>(it->second.size())) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+void VariableManager::releaseArray(ValueArray& array) {
+    for (const Value& value : array.data) {
+        stringBytes -= value.heapBytes();
+    }
+    arrayBytes -= array.data.size() * sizeof(Value);
+    for (const auto& page : array.pages) {
+        if (page) {
+            for (int i = 0; i < ValueArray::PAGE_SIZE; i++) {
+                stringBytes -= page[i].heapBytes();
+            }
+            arrayBytes -= PAGE_BYTES;
+        }
     }
-    
-    it->second[index] = value;
+    arrayBytes -= array.pages.size() * sizeof(array.pages[0]);
+    array = ValueArray();
 }
 
-double VariableManager::getArrayElement(const std::string& name, int index) {
-    std::string normalizedName = normalizeVariableName(name);
-    auto it = arrays.find(normalizedName);
-    if (it == arrays.end()) {
-        // Auto-dimension with default size 10
-        dimArray(normalizedName, 10);
-        it = arrays.find(normalizedName);
-    }
-    
-    if (index < 0 || index >= static_cast<int>(it->second.size())) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+void VariableManager::shapeArray(ValueArray& array, const std::vector<int>& extents, bool isString) {
+    array.shape = ArrayShape(extents);
+    array.fill = isString ? Value::emptyString() : Value();
+    if (array.shape.size > ValueArray::PAGED_THRESHOLD) {
+        array.pages.resize((array.shape.size + ValueArray::PAGE_SIZE - 1) / ValueArray::PAGE_SIZE);
+        arrayBytes += array.pages.size() * sizeof(array.pages[0]);
+    } else {
+        array.data.assign(array.shape.size, array.fill);
+        arrayBytes += array.data.size() * sizeof(Value);
     }
-    
-    return it->second[index];
 }
 
-bool VariableManager::isArray(const std::string& name) {
-    std::string normalizedName = normalizeVariableName(name);
-    return arrays.find(normalizedName) != arrays.end();
+Value& VariableManager::pagedElement(ValueArray& array, int offset) {
+    std::unique_ptr<Value[]>& page = array.pages[offset / ValueArray::PAGE_SIZE];
+    if (!page) {
+        page.reset(new Value[ValueArray::PAGE_SIZE]);
+        std::fill(page.get(), page.get() + ValueArray::PAGE_SIZE, array.fill);
+        arrayBytes += PAGE_BYTES;
+    }
+    return page[offset % ValueArray::PAGE_SIZE];
 }
 
-void VariableManager::setArrayElement(const std::string& name, const std::vector<int>& indices, double value) {
-    std::string normalizedName = normalizeVariableName(name);
-    auto arrayIt = arrays.find(normalizedName);
-    auto dimIt = arrayDimensions.find(normalizedName);
-    
-    if (arrayIt == arrays.end() || dimIt == arrayDimensions.end()) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
-    }
-    
-    // Validate indices and calculate linear index
-    if (indices.size() != dimIt->second.size()) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
-    }
-    
-    int linearIndex = 0;
-    int multiplier = 1;
-    for (int i = indices.size() - 1; i >= 0; i--) {
-        if (indices[i] < 0 || indices[i] >= dimIt->second[i]) {
-            throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
-        }
-        linearIndex += indices[i] * multiplier;
-        multiplier *= dimIt->second[i];
-    }
-    
-    arrayIt->second[linearIndex] = value;
+void VariableManager::dimArray(const std::string& name, int size) {
+    dimArray(name, std::vector<int>{size});
 }
 
-double VariableManager::getArrayElement(const std::string& name, const std::vector<int>& indices) {
-    std::string normalizedName = normalizeVariableName(name);
-    auto arrayIt = arrays.find(normalizedName);
-    auto dimIt = arrayDimensions.find(normalizedName);
-    
-    if (arrayIt == arrays.end() || dimIt == arrayDimensions.end()) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
-    }
-    
-    // Validate indices and calculate linear index
-    if (indices.size() != dimIt->second.size()) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+void VariableManager::dimArray(const std::string& name, const std::vector<int>& dimensions) {
+    int slot = slotFor(name);
+    if (slot < 0) {
+        throw std::runtime_error("ILLEGAL VARIABLE NAME");
     }
     
-    int linearIndex = 0;
-    int multiplier = 1;
-    for (int i = indices.size() - 1; i >= 0; i--) {
-        if (indices[i] < 0 || indices[i] >= dimIt->second[i]) {
-            throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+    std::vector<int> extents;
+    for (int dim : dimensions) {
+        if (dim < 0) {
+            throw std::runtime_error("ILLEGAL FUNCTION CALL");
         }
-        linearIndex += indices[i] * multiplier;
-        multiplier *= dimIt->second[i];
+        extents.push_back(dim + 1); // BASIC arrays include 0 index
     }
     
-    return arrayIt->second[linearIndex];
+    ValueArray& array = arrays[slot];
+    releaseArray(array);
+    shapeArray(array, extents, isStringSlot(slot));
 }
 
-void VariableManager::clearAll() {
-    numericVariables.clear();
-    stringVariables.clear();
-    arrays.clear();
-    stringArrays.clear();
-    arrayDimensions.clear();
-}
-
-bool VariableManager::isValidVariableName(const std::string& name) {
-    if (name.empty()) {
-        return false;
-    }
-    
-    // Must start with a letter
-    if (!std::isalpha(name[0])) {
-        return false;
+ValueArray* VariableManager::getArray(int slot, bool autoDimension) {
+    if (slot < 0) {
+        if (autoDimension) {
+            throw std::runtime_error("ILLEGAL VARIABLE NAME");
+        }
+        return nullptr;
     }
-    
-    // In Altair BASIC 4K, variables are single letter or letter+digit
-    if (name.length() == 1) {
-        return std::isalpha(name[0]);
-    } else if (name.length() == 2) {
-        // Could be A9 (numeric) or A$ (string)
-        if (name[1] == '$') {
-            return std::isalpha(name[0]); // A$ to Z$
-        } else {
-            return std::isalpha(name[0]) && std::isdigit(name[1]); // A0 to Z9
+    ValueArray& array = arrays[slot];
+    if (!array.isDimensioned()) {
+        if (!autoDimension) {
+            return nullptr;
         }
-    } else if (name.length() == 3 && name[2] == '$') {
-        // String variable (A0$ to Z9$)
-        return std::isalpha(name[0]) && std::isdigit(name[1]);
+        // Auto-dimension with default size 10
+        dimArray(nameForSlot(slot), 10);
     }
-    
-    return false;
+    return &array;
 }
 
-void VariableManager::setStringArrayElement(const std::string& name, int index, const std::string& value) {
-    std::string normalizedName = normalizeVariableName(name);
-    auto it = stringArrays.find(normalizedName);
-    
-    if (it == stringArrays.end()) {
-        // Array doesn't exist, create it with default size
-        stringArrays[normalizedName] = std::vector<std::string>(11, ""); // Default size 0-10
-        arrayDimensions[normalizedName] = {11};
-    }
-    
-    if (index < 0 || index >= static_cast<int>(it->second.size())) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+static void saveValue(SpillWriter& out, const Value& value) {
+    if (value.isString()) {
+        out.putString(value.text().str());
+    } else {
+        out.putDouble(value.number());
     }
-    
-    stringArrays[normalizedName][index] = value;
 }
 
-void VariableManager::setStringArrayElement(const std::string& name, const std::vector<int>& indices, const std::string& value) {
-    std::string normalizedName = normalizeVariableName(name);
-    auto arrayIt = stringArrays.find(normalizedName);
-    auto dimIt = arrayDimensions.find(normalizedName);
-    
-    if (arrayIt == stringArrays.end() || dimIt == arrayDimensions.end()) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
-    }
-    
-    if (indices.size() != dimIt->second.size()) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+static Value loadValue(SpillReader& in, bool isString) {
+    if (isString) {
+        return Value::string(in.getString());
     }
-    
-    int flatIndex = 0;
-    int multiplier = 1;
-    
-    for (int i = indices.size() - 1; i >= 0; i--) {
-        if (indices[i] < 0 || indices[i] >= dimIt->second[i]) {
-            throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
-        }
-        flatIndex += indices[i] * multiplier;
-        multiplier *= dimIt->second[i];
-    }
-    
-    arrayIt->second[flatIndex] = value;
+    return Value(in.getDouble());
 }
 
-std::string VariableManager::getStringArrayElement(const std::string& name, int index) {
-    std::string normalizedName = normalizeVariableName(name);
-    auto it = stringArrays.find(normalizedName);
-    
-    if (it == stringArrays.end()) {
-        // Array doesn't exist, create it with default size
-        stringArrays[normalizedName] = std::vector<std::string>(11, ""); // Default size 0-10
-        arrayDimensions[normalizedName] = {11};
-        return "";
+void VariableManager::save(SpillWriter& out) const {
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        saveValue(out, scalars[slot]);
     }
     
-    if (index < 0 || index >= static_cast<int>(it->second.size())) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        const ValueArray& array = arrays[slot];
+        out.putInt(array.shape.extents.size());
+        for (int extent : array.shape.extents) {
+            out.putInt(extent);
+        }
+        for (const Value& value : array.data) {
+            saveValue(out, value);
+        }
+        for (const auto& page : array.pages) {
+            out.putInt(page ? 1 : 0);
+            for (int i = 0; page && i < ValueArray::PAGE_SIZE; i++) {
+                saveValue(out, page[i]);
+            }
+        }
     }
-    
-    return it->second[index];
 }
 
-std::string VariableManager::getStringArrayElement(const std::string& name, const std::vector<int>& indices) {
-    std::string normalizedName = normalizeVariableName(name);
-    auto arrayIt = stringArrays.find(normalizedName);
-    auto dimIt = arrayDimensions.find(normalizedName);
-    
-    if (arrayIt == stringArrays.end() || dimIt == arrayDimensions.end()) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
-    }
+void VariableManager::load(SpillReader& in) {
+    clearAll();
     
-    if (indices.size() != dimIt->second.size()) {
-        throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        assign(scalars[slot], loadValue(in, isStringSlot(slot)));
     }
     
-    int flatIndex = 0;
-    int multiplier = 1;
-    
-    for (int i = indices.size() - 1; i >= 0; i--) {
-        if (indices[i] < 0 || indices[i] >= dimIt->second[i]) {
-            throw std::runtime_error("SUBSCRIPT OUT OF RANGE");
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        int64_t dimensions = in.getInt();
+        if (dimensions == 0) {
+            continue;
+        }
+        // The shape must be one DIM could have made: elements are addressed with an int
+        if (dimensions < 0 || dimensions > INT_MAX) {
+            throw std::runtime_error("BAD SPILL FILE");
+        }
+        std::vector<int> extents;
+        int64_t elements = 1;
+        for (int64_t d = 0; d < dimensions; d++) {
+            int64_t extent = in.getInt();
+            if (extent < 1 || extent > INT_MAX || elements > INT_MAX / extent) {
+                throw std::runtime_error("BAD SPILL FILE");
+            }
+            elements *= extent;
+            extents.push_back(static_cast<int>(extent));
+        }
+        ValueArray& array = arrays[slot];
+        shapeArray(array, extents, isStringSlot(slot));
+        for (Value& value : array.data) {
+            assign(value, loadValue(in, isStringSlot(slot)));
+        }
+        for (size_t page = 0; page < array.pages.size(); page++) {
+            if (in.getInt() == 0) {
+                continue;
+            }
+            // A saved page holds all PAGE_SIZE elements, including any past the
+            // end of the last page. Its first element is below the array's size.
+            size_t first = page * ValueArray::PAGE_SIZE;
+            Value* values = &pagedElement(array, static_cast<int>(first));
+            for (int i = 0; i < ValueArray::PAGE_SIZE; i++) {
+                assign(values[i], loadValue(in, isStringSlot(slot)));
+            }
         }
-        flatIndex += indices[i] * multiplier;
-        multiplier *= dimIt->second[i];
     }
-    
-    return arrayIt->second[flatIndex];
 }
 
-bool VariableManager::isStringArray(const std::string& name) {
-    std::string normalizedName = normalizeVariableName(name);
-    return stringArrays.find(normalizedName) != stringArrays.end();
+void VariableManager::clearAll() {
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        scalars[slot] = isStringSlot(slot) ? Value::emptyString() : Value();
+        arrays[slot] = ValueArray();
+    }
+    arrayBytes = 0;
+    stringBytes = 0;
 }
 
-std::string VariableManager::normalizeVariableName(const std::string& name) {
-    std::string normalized;
-    for (char c : name) {
-        normalized += std::toupper(c);
-    }
-    return normalized;
+bool VariableManager::isValidVariableName(const std::string& name) {
+    return slotFor(name) >= 0;
 }
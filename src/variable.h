@@ -1,52 +1,131 @@
 #ifndef VARIABLE_H
 #define VARIABLE_H
 
+#include "value.h"
+#include <memory>
 #include <string>
-#include <map>
 #include <vector>
 
+class SpillWriter;
+class SpillReader;
+
+// Row-major layout of a dimensioned array. Strides are worked out once at
+// DIM so indexing is a bounds check and a multiply-add per subscript.
+struct ArrayShape {
+    std::vector<int> extents;   // Elements along each dimension (DIM bound + 1)
+    std::vector<int> strides;   // Distance between neighbours along each dimension
+    int size;                   // Total number of elements
+    
+    ArrayShape() : size(0) {}
+    explicit ArrayShape(const std::vector<int>& dimensionExtents);
+};
+
+// Numeric and string arrays share one representation. Arrays of up to
+// PAGED_THRESHOLD elements are stored densely. Larger ones are split into
+// pages that are only allocated when first written, so DIM of a big table
+// is instant and memory is used only for the regions a program touches.
+struct ValueArray {
+    static const int PAGE_SIZE = 4096;
+    static const int PAGED_THRESHOLD = 65536;
+    
+    ArrayShape shape;
+    std::vector<Value> data;                        // Dense elements
+    std::vector<std::unique_ptr<Value[]>> pages;    // Paged elements, null until written
+    Value fill;                                     // What unwritten elements read as
+    
+    bool isDimensioned() const { return !shape.extents.empty(); }
+    bool isPaged() const { return !pages.empty(); }
+    
+    const Value& read(int offset) const {
+        if (!isPaged()) {
+            return data[offset];
+        }
+        const Value* page = pages[offset / PAGE_SIZE].get();
+        return page ? page[offset % PAGE_SIZE] : fill;
+    }
+};
+
+// Every legal name (A-Z and A0-Z9, each with or without $) has a fixed slot,
+// so the parser resolves a variable once and execution indexes a table.
+// Names without a slot read as 0 or "" and can't be assigned.
 class VariableManager {
+public:
+    static const int NUMERIC_SLOTS = 26 * 11;
+    static const int SLOT_COUNT = 2 * NUMERIC_SLOTS;
+    
+    // Slot of a variable or array name, or -1 if it isn't a legal name
+    static int slotFor(const std::string& name);
+    static std::string nameForSlot(int slot);
+    static bool isStringSlot(int slot) { return slot >= NUMERIC_SLOTS; }
+    
+    // User functions are FN followed by a numeric variable name, so they share
+    // its slot number; -1 for any other name
+    static int functionSlotFor(const std::string& name);
+    
 private:
-    std::map<std::string, double> numericVariables;
-    std::map<std::string, std::string> stringVariables;
-    std::map<std::string, std::vector<double>> arrays;
-    std::map<std::string, std::vector<std::string>> stringArrays;
-    std::map<std::string, std::vector<int>> arrayDimensions;
+    std::vector<Value> scalars;
+    std::vector<ValueArray> arrays;
+    size_t arrayBytes;      // Element storage of dimensioned arrays
+    size_t stringBytes;     // String blocks held by variables and elements
+    
+    void releaseArray(ValueArray& array);
+    void shapeArray(ValueArray& array, const std::vector<int>& extents, bool isString);
+    Value& pagedElement(ValueArray& array, int offset);
     
 public:
     VariableManager();
     
+    // Direct slot access for resolved names. Strings must be stored with
+    // assign() or append() so their bytes are accounted for.
+    Value& scalar(int slot) { return scalars[slot]; }
+    void assign(Value& target, Value value);
+    void append(Value& target, StringView tail);
+    
+    // Bytes held by the variable table, arrays and long strings. A string
+    // shared by several variables is charged to each, as if it were copied.
+    size_t bytesUsed() const;
+    
+    // Bytes DIM would allocate for these bounds, or SIZE_MAX if too large to address
+    static size_t arrayBytesFor(const std::vector<int>& dimensions);
+    
     // Numeric variable operations
     void setNumericVariable(const std::string& name, double value);
     double getNumericVariable(const std::string& name);
-    bool isNumericVariable(const std::string& name);
-    bool hasVariable(const std::string& name);
     
     // String variable operations
+    void setStringVariable(const std::string& name, const Value& value);
     void setStringVariable(const std::string& name, const std::string& value);
-    std::string getStringVariable(const std::string& name);
-    bool isStringVariable(const std::string& name);
+    Value getStringVariable(const std::string& name);
     
     // Array operations
     void dimArray(const std::string& name, int size);
     void dimArray(const std::string& name, const std::vector<int>& dimensions);
-    void setArrayElement(const std::string& name, int index, double value);
-    void setArrayElement(const std::string& name, const std::vector<int>& indices, double value);
-    double getArrayElement(const std::string& name, int index);
-    double getArrayElement(const std::string& name, const std::vector<int>& indices);
-    bool isArray(const std::string& name);
-    
-    // String array operations
-    void setStringArrayElement(const std::string& name, int index, const std::string& value);
-    void setStringArrayElement(const std::string& name, const std::vector<int>& indices, const std::string& value);
-    std::string getStringArrayElement(const std::string& name, int index);
-    std::string getStringArrayElement(const std::string& name, const std::vector<int>& indices);
-    bool isStringArray(const std::string& name);
+    
+    // Array descriptor for element access. An undimensioned array is created
+    // as DIM name(10) when autoDimension is set, otherwise nullptr is returned.
+    // The pointer stays valid until the array is redimensioned or cleared.
+    ValueArray* getArray(int slot, bool autoDimension);
+    
+    // Element for writing. Allocates the element's page on first write to a
+    // paged array; pageMissing() tells whether that would happen.
+    Value& writeElement(ValueArray& array, int offset) {
+        if (!array.isPaged()) {
+            return array.data[offset];
+        }
+        return pagedElement(array, offset);
+    }
+    static bool pageMissing(const ValueArray& array, int offset) {
+        return array.isPaged() && !array.pages[offset / ValueArray::PAGE_SIZE];
+    }
+    static const size_t PAGE_BYTES = ValueArray::PAGE_SIZE * sizeof(Value);
+    
+    // Session spill
+    void save(SpillWriter& out) const;
+    void load(SpillReader& in);
     
     // Utility
     void clearAll();
     bool isValidVariableName(const std::string& name);
-    std::string normalizeVariableName(const std::string& name);
 };
 
 #endif
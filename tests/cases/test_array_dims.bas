@@ -0,0 +1,12 @@
+5 REM MULTI-DIMENSIONAL ARRAYS
+10 DIM A(3,4,5), B$(2,3), C(4,4)
+20 FOR I=0 TO 3: FOR J=0 TO 4: FOR K=0 TO 5
+30 A(I,J,K) = I*100+J*10+K
+40 NEXT K: NEXT J: NEXT I
+50 PRINT A(2,3,4); A(3,4,5); A(0,0,0)
+70 B$(1,2) = "HI": B$(2,3) = "END"
+80 PRINT B$(1,2); B$(2,3); B$(5)
+90 C(2,3) = 7: PRINT C(13)
+100 D(3) = 4: PRINT D(3); D(10)
+110 E$(2) = "E": PRINT E$(2)
+120 PRINT A(4,0,0)
@@ -0,0 +1,22 @@
+10 REM ARRAY LOOPS RUN AS NATIVE KERNELS
+20 N=1000: K=2.5
+30 DIM A(N),B(N),C(N),D(N)
+40 FOR I=0 TO N: B(I)=I*1.5: C(I)=N-I: NEXT I
+50 FOR I=1 TO N: A(I)=B(I)*K+C(I): NEXT I
+60 PRINT "AXPY:"; I; A(1); A(N); A(500)
+70 FOR I=N TO 2 STEP -3: D(I)=A(I)-B(I-1)/3: A(I)=A(I)*2+D(I): NEXT I
+80 PRINT "DOWN:"; I; D(N); A(N); D(4); A(4); D(3)
+90 FOR J=2 TO N-1
+100 D(J)=(B(J-1)+B(J+1))/2-SQR(ABS(C(J)))+J^2
+110 NEXT J
+120 PRINT "STENCIL:"; J; D(2); D(N-1)
+130 FOR I=1 TO 10.5: A(I)=-A(I)+NOT B(I): NEXT I
+140 PRINT "FRACTIONAL END:"; I; A(1); A(10)
+150 REM EACH ELEMENT DEPENDS ON THE PREVIOUS ONE
+160 A(0)=0
+170 FOR I=1 TO N: A(I)=A(I-1)+1: NEXT I
+180 PRINT "RECURRENCE:"; I; A(N)
+190 REM A ZERO DIVISOR STOPS THE LOOP WHERE IT IS
+200 B(700)=0
+210 FOR I=1 TO N: D(I)=C(I)/B(I): NEXT I
+220 PRINT "NOT REACHED"
@@ -0,0 +1,8 @@
+10 REM CONSTANT SUBEXPRESSIONS AND LITERALS
+20 PRINT 3.14159 / 180; 2 * 3 > 5; 1 = 2; NOT 0; 3 AND 0; 2 OR 0
+30 PRINT SQR(16) + INT(7.9); ABS(-3); SGN(-2); LEN("HELLO"); ASC("A"); VAL("12.5")
+40 PRINT SIN(0) + COS(0); EXP(0); ATN(0); -(2 ^ 3)
+50 FOR I = 1 TO 3: PRINT I * (1 + 1) + .5; : NEXT I
+60 PRINT
+80 X = 2: PRINT X * 4 / 2 ^ 2 + (10 - 4) / 3
+90 PRINT SQR(-1)
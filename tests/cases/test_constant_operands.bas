@@ -0,0 +1,11 @@
+10 REM CONSTANT POWERS AND DIVISORS
+20 X = 1.7: Y = -2.5
+30 PRINT X ^ 2; Y ^ 2; X ^ 3; Y ^ 3; X ^ 4; Y ^ 4
+40 PRINT X ^ .5; 16 ^ .5; 0 ^ .5; Y ^ .5
+50 PRINT X / 4; Y / 8; X / 10; Y / 3; X / .25
+60 PRINT 2 + 3 * 4; (2 + 3) * 4; -(4 - 6); 2 ^ 10; 1 / 3; 7 - -2
+70 PRINT 3.14159 / 180 * 90
+80 FOR I = 1 TO 5: S = S + I ^ 2 + I / 2: NEXT I
+90 PRINT S
+100 A$ = "AB"
+110 PRINT X / 0
@@ -0,0 +1,11 @@
+10 READ A, B
+20 PRINT A; B
+30 DATA 1, 2
+RUN
+30
+30 DATA 5, 6
+RUN
+GOTO 10
+25 DATA 9
+RUN
+30
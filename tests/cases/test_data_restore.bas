@@ -0,0 +1,24 @@
+5 DATA 1, "2", 3
+10 REM TYPED DATA TABLE AND RESTORE TO A LINE
+20 READ A, B$, C
+30 PRINT A; B$; C
+40 RESTORE 1000
+50 READ N$, X
+60 PRINT N$; X
+70 RESTORE 900
+80 READ Y$
+85 RESTORE 1010: READ Y
+90 PRINT Y$; Y
+100 DIM T(3), T$(3)
+110 RESTORE
+120 FOR I = 1 TO 3: READ T(I): NEXT I
+130 RESTORE 1000
+140 FOR I = 1 TO 3: READ T$(I): NEXT I
+150 PRINT T(1) + T(2) + T(3); T$(1); T$(2); T$(3)
+160 RESTORE 2000
+170 READ Z
+180 PRINT "OUT OF RANGE"
+190 END
+900 REM NO DATA ON THIS LINE
+1000 DATA "HELLO", 1.50, ZIG
+1010 DATA 7
@@ -0,0 +1,18 @@
+10 REM FN PARAMETERS ARE LOCAL TO EACH CALL
+20 X = 5: Y = 7
+30 DEF FNA(X) = X * X + Y
+40 PRINT FNA(3); X
+50 DEF FNB(Y) = FNA(Y + 1) * 2 + Y
+60 PRINT FNB(2); X; Y
+70 DIM X(3): X(2) = 9
+80 DEF FNC(X) = X(X) + X
+90 PRINT FNC(2)
+100 FOR I = 1 TO 2
+110 IF I = 1 THEN DEF FND(Z) = Z + 100
+120 IF I = 2 THEN DEF FND(Z) = Z + 200
+130 PRINT FND(I);
+140 NEXT I
+150 PRINT
+160 FOR I = 1 TO 3: PRINT FNA(I) + X * 2; : NEXT I
+170 PRINT
+180 PRINT FNQ(1)
@@ -0,0 +1,21 @@
+10 REM FOR/NEXT frames updated in place
+20 FOR I = 1 TO 3
+30 PRINT I;: NEXT I
+40 PRINT
+50 FOR I = 1 TO 2: FOR J = 3 TO 1 STEP -1
+60 PRINT I * 10 + J;
+70 NEXT J: NEXT I
+80 PRINT
+90 FOR K = 1 TO 3: PRINT K;: NEXT: PRINT
+100 FOR I = 1 TO 10
+110 IF I = 4 THEN 130
+120 NEXT I
+130 PRINT "LEFT AT"; I
+140 FOR I = 1 TO 2
+150 FOR J = 1 TO 5
+160 IF J = 2 THEN 180
+170 NEXT J
+180 NEXT I
+190 PRINT I; J
+200 FOR X = 1 TO 2: FOR Y = 1 TO 2
+210 NEXT X
@@ -0,0 +1,24 @@
+10 REM IF conditions evaluated as branches
+20 A = 3: B = 5: A$ = "ABC": B$ = "ABD"
+30 IF A < B THEN PRINT "LESS"
+40 IF A < B AND B < A THEN PRINT "WRONG"
+50 IF A > B OR B > A THEN PRINT "EITHER"
+60 IF NOT A = B THEN PRINT "NOT EQUAL"
+70 IF A THEN PRINT "NONZERO"
+80 IF A - 3 THEN PRINT "WRONG"
+90 IF A$ < B$ THEN PRINT "STRING LESS"
+100 IF A$ = "ABC" AND A = 3 THEN PRINT "BOTH"
+110 IF (A < B) + (A = 3) = -2 THEN PRINT "SUM OF TRUTHS"
+120 IF A AND 0 THEN PRINT "WRONG"
+130 IF 0 OR B THEN PRINT "OR VALUE"
+140 IF NOT 0 THEN PRINT "NOT ZERO"
+150 FOR I = 1 TO 5
+160 FOR J = 1 TO 5
+170 IF J = 2 THEN 200
+180 NEXT J
+190 PRINT "WRONG"
+200 IF I = 3 THEN 220
+210 NEXT I
+220 PRINT "OUT AT"; I; J
+230 FOR K = 1 TO 2: NEXT K
+240 IF A$ = A THEN PRINT "WRONG"
@@ -0,0 +1,21 @@
+10 REM INPUT answered by later lines, including inside IF, FOR and GOSUB
+20 INPUT "FIRST"; A
+30 IF A > 0 THEN INPUT "SECOND"; B: PRINT "INSIDE IF"; B
+40 T = 0: FOR I = 1 TO 2: INPUT C: T = T + C: NEXT I
+50 INPUT "PAIR"; D, E
+60 INPUT "NAME"; N$
+70 PRINT A; B; T; D; E; N$
+80 IF A = 5 THEN GOSUB 200: PRINT "BACK"
+90 END
+200 INPUT "SUB"; S
+210 PRINT "S ="; S
+220 RETURN
+RUN
+5
+7
+1
+2
+3
+ABC
+4, 6
+SAM
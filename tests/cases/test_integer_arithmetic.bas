@@ -0,0 +1,23 @@
+10 REM Integer fast path edge cases
+20 DIM A(20), B(4,4)
+30 FOR I = 1 TO 10
+40 A(I) = I * I - 3 * I + 2
+50 NEXT I
+60 FOR I = 1 TO 10: PRINT A(I);: NEXT I
+70 PRINT
+80 FOR I = 0 TO 4: FOR J = 0 TO 4
+90 B(I, J) = I * 5 + J
+100 NEXT J: NEXT I
+110 PRINT B(2, 3); B(4, 4); B(I - 1, J - 2)
+120 K = 0: N = -3
+130 PRINT K * N; -K; (K * N) ^ -1; (-K) ^ -1; (K * 5) ^ -1
+140 M = 94906265: PRINT M * M; M * M + 1 - M * M
+150 P = 4503599627370496: PRINT P + P; P * 2 + 1; P * P
+160 Q = 1: FOR I = 1 TO 70: Q = Q * 3: NEXT I: PRINT Q; Q + 1 - Q
+170 R = 7: PRINT INT(R / 2); INT(-R / 2); ABS(-R); SGN(-R); SGN(K); -R ^ 2; R ^ 3; R ^ 4
+180 PRINT (R > 3) + (R < 3) * 2; NOT R; NOT K; R AND 0; R OR K
+190 S = 0: FOR I = 10 TO 1 STEP -3: S = S + I * (I - 1): NEXT I: PRINT S; I
+200 T = 1.5: FOR I = T TO 4: PRINT I + 1;: NEXT I: PRINT
+210 U = 0: FOR I = 1 TO 3: U = U + I / 2: NEXT I: PRINT U * 2; A(U - 2)
+220 PRINT A(INT(R / 3) + 1); A(R - 6); A(2 * 3)
+230 V = -0: PRINT V * 1; -V
@@ -0,0 +1,21 @@
+10 REM GOTO, GOSUB and THEN targets resolved before the run
+20 FOR I = 1 TO 3
+30 FOR J = 1 TO 3
+40 IF J = 2 THEN 70
+50 NEXT J
+60 PRINT "WRONG"
+70 GOSUB 200
+80 NEXT I
+90 N = 0
+100 N = N + 1
+105 IF N < 5 THEN 100
+110 PRINT "N ="; N
+120 FOR K = 1 TO 3
+130 IF K = 2 THEN GOTO 150
+140 NEXT K
+150 PRINT "LEFT K AT"; K
+160 FOR K = 1 TO 2: PRINT "K"; K: NEXT K
+180 IF N = 5 THEN 999
+190 END
+200 PRINT "I ="; I; "J ="; J
+210 RETURN
@@ -0,0 +1,27 @@
+10 REM STRINGS LONGER THAN THE INLINE LIMIT
+20 A$ = "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG"
+30 B$ = A$
+40 C$ = "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG"
+50 IF A$ = B$ THEN PRINT "SHARED EQUAL"
+60 IF A$ = C$ THEN PRINT "LITERAL EQUAL"
+70 B$ = B$ + "!"
+80 PRINT A$
+90 PRINT B$
+100 PRINT LEN(A$); LEN(B$)
+110 IF A$ < B$ THEN PRINT "PREFIX SORTS FIRST"
+120 DIM S$(3)
+130 FOR I = 0 TO 3
+140 S$(I) = LEFT$(A$, 20 + I) + STR$(I)
+150 NEXT I
+160 FOR I = 3 TO 0 STEP -1
+170 PRINT S$(I)
+180 NEXT I
+190 PRINT MID$(A$, 17, 15); "|"; RIGHT$(A$, 24)
+200 D$ = "12345678901234567890123"
+210 E$ = D$ + "4"
+220 PRINT LEN(D$); LEN(E$); E$
+230 IF D$ <> E$ THEN PRINT "DIFFERENT"
+240 READ F$, G$
+250 PRINT F$; G$
+260 DATA "A DATA ITEM THAT IS QUITE LONG INDEED", ", AND A SHORT ONE"
+270 END
@@ -0,0 +1,33 @@
+10 REM LOOP-INVARIANT EXPRESSIONS GIVE THE SAME RESULTS
+20 W = 10: H = 4: DIM A(5)
+30 FOR K = 1 TO 5: A(K) = K * K: NEXT K
+40 FOR R = 1 TO 2
+50 T = 0
+60 FOR I = 1 TO 3
+70 T = T + W / 2 + I * H + A(R + 1)
+80 NEXT I
+90 PRINT R; T
+100 W = W + 1
+110 NEXT R
+120 S$ = "AB"
+130 FOR I = 1 TO 3: PRINT S$ + "CD"; MID$(S$ + "XYZW", 2, 3); : NEXT I
+140 PRINT
+150 FOR I = 1 TO 3
+160 A(2) = A(2) + A(3) * 2
+170 PRINT A(2);
+180 NEXT I
+190 PRINT
+200 FOR C = 1 TO 3
+210 FOR I = 1 TO 2: Y = X * 3 + 1: PRINT Y; : NEXT I
+220 X = X + 5: NEXT C
+230 PRINT
+280 FOR I = 1 TO 3
+290 IF W > 5 THEN Z = Z + W * 2
+300 PRINT Z;
+310 NEXT I
+320 PRINT
+330 FOR I = 1 TO 2: FOR J = 1 TO 2: PRINT I * 10 + H * 100 + J; : NEXT J: NEXT I
+340 PRINT
+350 FOR I = 1 TO 3: PRINT INT(RND(1) * 0) + W * 0; : NEXT I
+360 PRINT
+370 D = 0: FOR I = 1 TO 2: PRINT I; 1 / D: NEXT I
@@ -0,0 +1,51 @@
+10 REM MAT STATEMENT TESTS
+20 DIM A(2,3), B(3,2), V(3)
+30 MAT READ A, B
+40 PRINT "A:"
+50 MAT PRINT A
+60 PRINT "B PACKED:"
+70 MAT PRINT B;
+80 MAT C = A * B
+90 PRINT "A*B:"
+100 MAT PRINT C
+110 MAT T = TRN(A)
+120 MAT D = T + B
+130 PRINT "TRN(A)+B:"
+140 MAT PRINT D
+150 MAT D = D - B
+160 MAT PRINT D
+170 MAT E = (2.5) * C
+180 MAT PRINT E
+190 MAT I = IDN(3)
+200 MAT PRINT I;
+210 MAT Z = ZER(2)
+220 MAT O = CON(2,2)
+230 MAT PRINT Z; O;
+240 DIM M(2,2)
+250 MAT READ M
+260 MAT N = INV(M)
+270 MAT P = M * N
+280 PRINT "INVERSE:"
+290 MAT PRINT N
+300 MAT PRINT P
+310 MAT READ V
+320 MAT W = A * V
+330 PRINT "A*V:"
+340 MAT PRINT W
+350 MAT C = C * C
+360 MAT PRINT C
+370 MAT M = CON
+380 MAT PRINT M;
+390 DIM S$(2)
+400 MAT READ S$
+410 MAT PRINT S$
+420 MAT Q = M
+430 PRINT Q(1,1); Q(2,2)
+440 PRINT "SINGULAR:"
+450 MAT N = INV(M)
+460 PRINT "NOT REACHED"
+900 DATA 1,2,3,4,5,6
+910 DATA 1,0,0,1,1,1
+920 DATA 4,7,2,6
+930 DATA 1,1,1
+940 DATA "HELLO","WORLD"
@@ -0,0 +1,12 @@
+10 REM FRE AND THE PER-SESSION MEMORY LIMIT
+20 F = FRE(0)
+30 DIM A(99)
+40 PRINT "DIM A(99) USES"; F - FRE(0)
+50 A$ = "LITERALS ARE PART OF THE PROGRAM"
+60 PRINT "LITERAL USES"; F - FRE(0) - 800
+70 FOR I = 1 TO 3: A$ = A$ + A$: NEXT I
+80 PRINT LEN(A$); FRE("") < F - 800
+90 A$ = ""
+100 PRINT "FREED"; F - FRE(0)
+110 DIM B(100000, 100000)
+120 PRINT "NOT REACHED"
@@ -0,0 +1,14 @@
+10 REM Compiled PRINT statements
+20 A$ = "AB": N = 42
+30 PRINT "ZONES", N, A$
+40 PRINT "TAB"; TAB(10); N; TAB(5); "BACK"
+50 PRINT A$ + "CD"; LEN(A$); MID$(A$, 2, 1)
+60 PRINT "NO NEWLINE";
+70 PRINT " CONTINUED"
+80 PRINT TAB(3);
+90 PRINT "AFTER TAB ONLY"
+100 PRINT
+110 PRINT ,"SECOND ZONE"
+120 FOR I = 1 TO 3: PRINT I;: NEXT I: PRINT
+130 IF N > 0 THEN PRINT "IN IF"; N
+140 PRINT "BEFORE ERROR"; 1 / 0
@@ -0,0 +1,14 @@
+10 REM Single precision output: 6 significant digits, E notation outside .01 to 1E+06
+20 PRINT 1/3; 2/3; 10/3; 100/7
+30 PRINT 123456.4; 123456.6; 999999.4; 999999.7
+40 PRINT 1000000; 1234567; 12345678; 16777217
+50 PRINT .01; .009; .0012345; .0000123456
+60 PRINT -1/3; -999999.7; -.000123456; -2/30000
+70 PRINT 3.1415926; 2.7182818; SQR(2); 2^100
+80 PRINT 0.1 + 0.2; 1 - 1/3; 1/2^100; 10^6 - 1
+90 A = 1
+100 FOR I = 1 TO 8: A = A * 10: PRINT A;: NEXT I
+110 PRINT
+120 A = 1
+130 FOR I = 1 TO 5: A = A / 10: PRINT A;: NEXT I
+140 PRINT
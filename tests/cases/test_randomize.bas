@@ -0,0 +1,22 @@
+10 REM RANDOMIZE and RND seeding
+20 RANDOMIZE 42
+30 A = RND(1): B = RND(1)
+40 RANDOMIZE 42
+50 IF RND(1) = A THEN PRINT "SAME SEQUENCE AFTER RANDOMIZE"
+60 IF RND(0) = A THEN PRINT "RND(0) REPEATS LAST"
+70 IF RND(1) = B THEN PRINT "SECOND VALUE MATCHES"
+80 X = RND(-5): Y = RND(-5)
+90 IF X = Y THEN PRINT "NEGATIVE ARGUMENT RESEEDS"
+100 F = 0
+110 FOR I = 1 TO 1000
+120 R = RND(1): IF R < 0 OR R >= 1 THEN F = 1
+130 NEXT I
+140 IF F = 0 THEN PRINT "ALL VALUES IN RANGE"
+142 RANDOMIZE 10^30: A = RND(1): RANDOMIZE 10^30
+143 IF RND(1) = A THEN PRINT "HUGE SEED REPEATS"
+144 RANDOMIZE -(10^30): B = RND(1): IF B <> A THEN PRINT "NEGATIVE HUGE SEED DIFFERS"
+145 X = RND(-(10^30)): Y = RND(-(10^30)): IF X = Y THEN PRINT "HUGE NEGATIVE ARGUMENT RESEEDS"
+146 RANDOMIZE 2.75: A = RND(1): RANDOMIZE 2
+147 IF RND(1) = A THEN PRINT "FRACTIONAL SEED USES ITS INTEGER PART"
+148 X = RND(-2.5): Y = RND(-2): IF X = Y THEN PRINT "FRACTIONAL ARGUMENT USES ITS INTEGER PART"
+150 END
@@ -0,0 +1,13 @@
+10 REM LARGE ARRAYS ARE ONLY ALLOCATED WHERE THEY ARE WRITTEN
+20 F = FRE(0)
+30 DIM B(1000000, 1000), S$(200000)
+40 PRINT "DIM COSTS LESS THAN 3MB"; F - FRE(0) < 3000000
+50 F = FRE(0)
+60 PRINT B(123456, 789); "["; S$(199999); "]"
+70 PRINT "READS ARE FREE"; F - FRE(0)
+80 B(123456, 789) = 42: B(123456, 790) = 43
+90 S$(199999) = "LAST"
+100 PRINT "TWO PAGES"; F - FRE(0)
+110 PRINT B(123456, 789) + B(123456, 790); "["; S$(199999); "]"; B(999999, 1000)
+120 DIM B(2)
+130 PRINT "REDIM RELEASES PAGES"; F - FRE(0) < 0
@@ -0,0 +1,17 @@
+10 REM BUILDING STRINGS BY APPENDING TO THEMSELVES
+20 A$ = ""
+30 FOR I = 1 TO 40
+40 A$ = A$ + CHR$(64 + (I - 1) - INT((I - 1) / 26) * 26 + 1)
+50 NEXT I
+60 PRINT A$; LEN(A$)
+70 B$ = A$
+80 A$ = A$ + "-" + A$
+90 PRINT A$
+100 PRINT B$
+110 C$ = "X"
+120 C$ = C$ + C$ + C$
+130 PRINT C$
+140 L$ = ""
+150 FOR I = 1 TO 3: L$ = L$ + STR$(I) + ",": NEXT I
+160 PRINT L$
+170 END
@@ -0,0 +1,18 @@
+10 REM SUBSTRINGS OF VARIABLES, ARRAYS AND COMPUTED STRINGS
+20 A$ = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+30 N = 0
+40 FOR I = 1 TO LEN(A$)
+50 IF MID$(A$, I, 1) = "Q" THEN N = I
+60 NEXT I
+70 PRINT "Q AT"; N
+80 DIM W$(2)
+90 W$(1) = "ALTAIR EIGHT EIGHT HUNDRED"
+100 PRINT LEFT$(W$(1), 6); "|"; RIGHT$(W$(1), 7); "|"; MID$(W$(1), 8, 5)
+110 PRINT MID$(LEFT$(A$, 33), 30, 20)
+120 PRINT LEN(MID$(A$, 20, 5)); ASC(RIGHT$(A$, 1)); VAL(MID$(A$, 28, 3))
+130 IF LEFT$(A$, 3) < MID$(A$, 2, 3) THEN PRINT "ABC BEFORE BCD"
+140 IF RIGHT$(A$, 0) = "" THEN PRINT "EMPTY RIGHT$"
+150 B$ = MID$(A$, 5, 30)
+160 A$ = "CHANGED"
+170 PRINT B$; " "; A$
+180 END
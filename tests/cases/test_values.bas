@@ -0,0 +1,18 @@
+10 REM NUMBERS AND STRINGS SHARE ONE VALUE TYPE
+20 A$ = "SHORT"
+30 B$ = "SIXCHR"
+40 C$ = "SEVENCH"
+50 PRINT A$ + B$; "|"; B$ + "!"; "|"; LEN(C$)
+60 DIM N(3), S$(3)
+70 S$(1) = C$
+80 S$(2) = S$(1) + S$(1)
+90 C$ = "X"
+100 PRINT S$(1); " "; S$(2); " "; C$
+110 PRINT MID$(S$(1) + A$, 6, 4); " "; LEFT$(S$(2), 9)
+120 A1$ = "A1": A1 = 1: Z9 = 9
+130 PRINT A1$; A1; Z9
+160 FOR I = 1 TO 3: N(I) = I * I: NEXT I
+170 PRINT N(1) + N(2) + N(3)
+180 IF S$(1) + "X" = "SEVENCHX" THEN PRINT "COMPUTED COMPARE"
+190 X = A$
+200 END
@@ -33,13 +33,17 @@ for test_file in "$CASES_DIR"/*.bas; do
     base_name=$(basename "$test_file")
     expected_file="$EXPECTED_DIR/$base_name.expected"
     actual_output_file="$TEMP_OUTPUT_DIR/$base_name.actual"
+    options=""
+    case "$base_name" in
+        *_single.bas) options="--single" ;;
+    esac
 
     # Run the test
     (
         echo "NEW"
         cat "$test_file"
         echo "RUN"
-    ) | $ALTAIR_EGO_EXEC > "$actual_output_file" 2>&1
+    ) | $ALTAIR_EGO_EXEC $options > "$actual_output_file" 2>&1
 
     # Compare the output, ignoring trailing whitespace
     if diff -ub --strip-trailing-cr "$expected_file" "$actual_output_file" > /dev/null; then
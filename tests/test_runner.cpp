@@ -0,0 +1,476 @@
+// In-process BASIC interpreter test runner
+//
+// Runs every tests/cases/*.bas in its own interpreter instance on a pool of
+// threads, feeding it "NEW", the program and "RUN" exactly as
+// run_all_tests.sh does through a pipe, and compares the captured output with
+// tests/expected/<name>.bas.expected (ignoring whitespace amount and CRs).
+// Cases named *_single.bas run in single precision, as with --single.
+// The session checks below drive an interpreter directly, for behaviour a
+// program and its output can't show.
+
+#include "batch.h"
+#include "interpreter.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define GREEN "\033[0;32m"
+#define RED "\033[0;31m"
+#define NC "\033[0m"
+
+struct TestCase {
+    std::string name;
+    std::string casePath;
+    std::string expectedPath;
+    bool passed;
+    std::string diff;
+    std::string (*check)();     // Session check, returning what went wrong if anything
+};
+
+static bool readFile(const std::string& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    contents = ss.str();
+    return true;
+}
+
+// Mirrors the interactive loop in main.cpp with stdin/stdout replaced by strings
+static std::string runSession(const std::string& program, bool singlePrecision) {
+    std::istringstream input("NEW\n" + program + "RUN\n");
+    std::ostringstream output;
+
+    AltairBasicInterpreter interpreter;
+    interpreter.setStreams(input, output);
+    interpreter.setNonBlockingInput(true);
+    interpreter.setSinglePrecision(singlePrecision);
+
+    output << "Altair Ego: Emulating Altair BASIC 32K Rev. 3.2" << std::endl;
+    output << "OK" << std::endl;
+
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.empty() && !interpreter.isAwaitingInput()) {
+            continue;
+        }
+        try {
+            interpreter.processLine(line);
+        } catch (const std::exception& e) {
+            output << e.what() << std::endl;
+        }
+    }
+    interpreter.closeInput();
+    return output.str();
+}
+
+// Same normalization as diff -b --strip-trailing-cr: runs of whitespace
+// compare equal and trailing whitespace is ignored
+static std::vector<std::string> normalizedLines(const std::string& text) {
+    std::vector<std::string> lines;
+    std::istringstream ss(text);
+    std::string line;
+    while (std::getline(ss, line)) {
+        std::string normalized;
+        bool pendingSpace = false;
+        for (char c : line) {
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                pendingSpace = true;
+                continue;
+            }
+            if (pendingSpace) {
+                normalized += ' ';
+            }
+            pendingSpace = false;
+            normalized += c;
+        }
+        lines.push_back(normalized);
+    }
+    return lines;
+}
+
+// Feeds lines to a session the way the interactive loop does
+static void feedLines(AltairBasicInterpreter& interpreter, const std::string& lines) {
+    std::istringstream input(lines);
+    std::string line;
+    while (std::getline(input, line)) {
+        interpreter.processLine(line);
+    }
+}
+
+static int countDirectoryEntries(const std::string& path) {
+    int count = 0;
+    if (DIR* dir = opendir(path.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            count += entry->d_name[0] != '.';
+        }
+        closedir(dir);
+    }
+    return count;
+}
+
+// A program suspended in INPUT inside a FOR loop and a GOSUB, with arrays
+// (one of them paged), strings and RND state live, is spilled at each prompt and must carry on
+// exactly as it does when left in memory
+static std::string checkSpillAndRehydrate() {
+    const std::string program =
+        "NEW\n"
+        "10 DIM A(20), B$(3), C(300, 300)\n"
+        "20 FOR I = 1 TO 20: A(I) = I * I: NEXT I\n"
+        "30 B$(2) = \"SAVED\": R = RND(1): C(0, 1) = 2: C(300, 300) = 3\n"
+        "40 FOR J = 1 TO 2\n"
+        "50 GOSUB 100\n"
+        "60 NEXT J\n"
+        "70 PRINT \"DONE\"; A(20); B$(2); RND(1)\n"
+        "80 END\n"
+        "100 INPUT X\n"
+        "110 PRINT \"J=\"; J; \"A(X)=\"; A(X); B$(2); RND(1); C(0, 1); C(300, 300); C(150, 150)\n"
+        "120 RETURN\n"
+        "RUN\n";
+    const char* answers[] = {"3", "7"};
+
+    std::ostringstream expected, actual;
+    std::istringstream noInput;
+    AltairBasicInterpreter reference;
+    reference.setStreams(noInput, expected);
+    reference.setNonBlockingInput(true);
+    reference.seedRandom(7);
+    feedLines(reference, program);
+    for (const char* answer : answers) {
+        feedLines(reference, std::string(answer) + "\n");
+    }
+
+    char dirTemplate[] = "/tmp/altair-test-XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        return "cannot create a spill directory\n";
+    }
+    std::string spillDir = dirTemplate;
+    std::string problems;
+
+    AltairBasicInterpreter session;
+    session.setStreams(noInput, actual);
+    session.setNonBlockingInput(true);
+    session.seedRandom(7);
+    feedLines(session, program);
+    for (const char* answer : answers) {
+        // A directory that can't be written leaves the session in memory
+        session.setIdleSpill(1, spillDir + "/missing");
+        session.spillSession();
+        if (session.isSpilled() || !session.isAwaitingInput()) {
+            problems += "a failed spill lost the session\n";
+        }
+
+        session.setIdleSpill(1, spillDir);
+        session.spillSession();
+        if (!session.isSpilled() || countDirectoryEntries(spillDir) != 1) {
+            problems += "session was not spilled to " + spillDir + "\n";
+        }
+        feedLines(session, std::string(answer) + "\n");
+        if (session.isSpilled() || countDirectoryEntries(spillDir) != 0) {
+            problems += "spill file was not removed on rehydration\n";
+        }
+    }
+    rmdir(spillDir.c_str());
+
+    if (expected.str().find("DONE") == std::string::npos) {
+        problems += "reference run did not finish:\n" + expected.str();
+    }
+    if (actual.str() != expected.str()) {
+        problems += "--- in memory\n" + expected.str() + "+++ spilled\n" + actual.str();
+    }
+    return problems;
+}
+
+// Replays two transcripts with the same answers through --batch. Each gets its
+// own RND seed from its name, so their numbers differ, and a second replay
+// gives exactly the same records.
+// A spill file deleted while the session waits, as a tmp cleaner might, loses
+// the program's state: the answer reports the error once and the session is
+// left stopped and usable
+static std::string checkLostSpillFile() {
+    char dirTemplate[] = "/tmp/altair-test-XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        return "cannot create a spill directory\n";
+    }
+    std::string spillDir = dirTemplate;
+
+    std::ostringstream output;
+    std::istringstream noInput;
+    AltairBasicInterpreter session;
+    session.setStreams(noInput, output);
+    session.setNonBlockingInput(true);
+    session.setIdleSpill(1, spillDir);
+    feedLines(session, "NEW\n10 FOR I = 1 TO 2: GOSUB 100: NEXT I\n20 END\n100 INPUT X: RETURN\nRUN\n");
+    session.spillSession();
+
+    std::string problems;
+    if (!session.isSpilled()) {
+        problems += "session was not spilled to " + spillDir + "\n";
+    }
+    if (DIR* dir = opendir(spillDir.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                std::remove((spillDir + "/" + entry->d_name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(spillDir.c_str());
+
+    size_t before = output.str().size();
+    feedLines(session, "3\n");
+    std::string answer = output.str().substr(before);
+    if (answer.find("CAN'T OPEN " + spillDir) != 0 || answer.find("OK") == std::string::npos) {
+        problems += "lost spill file reported as:\n" + answer;
+    }
+    if (session.isSpilled() || session.isAwaitingInput()) {
+        problems += "session still spilled or waiting for input\n";
+    }
+
+    before = output.str().size();
+    feedLines(session, "NEW\n10 PRINT \"AGAIN\"\nRUN\n");
+    std::string rerun = output.str().substr(before);
+    if (rerun != "OK\nAGAIN\nOK\n") {
+        problems += "session after a lost spill file printed:\n" + rerun;
+    }
+    return problems;
+}
+
+static std::string checkBatchReplay() {
+    const char* program[] = {
+        "10 INPUT A$",
+        "20 PRINT \"HELLO \"; A$; RND(1)",
+        "30 INPUT N",
+        "40 PRINT N * 2",
+    };
+    const char* transcripts[] = {"first.txt", "second.txt"};
+
+    char dirTemplate[] = "/tmp/altair-test-XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        return "cannot create a transcript directory\n";
+    }
+    std::string transcriptDir = dirTemplate;
+    for (const char* name : transcripts) {
+        std::ofstream(transcriptDir + "/" + name) << "ADA\n21\n";
+    }
+
+    std::ostringstream loadOutput;
+    std::istringstream noInput;
+    AltairBasicInterpreter interpreter;
+    interpreter.setStreams(noInput, loadOutput);
+    for (const char* line : program) {
+        interpreter.processLine(line);
+    }
+
+    std::ostringstream firstRun, secondRun;
+    BatchOptions options;
+    options.transcriptDir = transcriptDir;
+    options.threads = 2;
+    options.records = &firstRun;
+    int firstStatus = runBatch(interpreter, options);
+    options.records = &secondRun;
+    int secondStatus = runBatch(interpreter, options);
+
+    for (const char* name : transcripts) {
+        std::remove((transcriptDir + "/" + name).c_str());
+    }
+    rmdir(transcriptDir.c_str());
+
+    // Peak memory depends on the platform's type sizes, so only its presence is checked
+    std::string records = firstRun.str();
+    for (size_t at = records.find("\"peakMemory\":"); at != std::string::npos; at = records.find("\"peakMemory\":", at + 1)) {
+        size_t digits = at + 13;
+        size_t end = records.find_first_not_of("0123456789", digits);
+        if (end == digits || end == std::string::npos) {
+            return "bad peakMemory in:\n" + firstRun.str();
+        }
+        records.replace(digits, end - digits, "N");
+    }
+
+    const std::string expected =
+        "{\"transcript\":\"first.txt\",\"seed\":1038912551,\"error\":false,\"peakMemory\":N,"
+        "\"output\":\"? HELLO ADA 0.552245 \\n?  42 \\n\"}\n"
+        "{\"transcript\":\"second.txt\",\"seed\":2921832731,\"error\":false,\"peakMemory\":N,"
+        "\"output\":\"? HELLO ADA 0.772446 \\n?  42 \\n\"}\n";
+
+    std::string problems;
+    if (firstStatus != 0 || secondStatus != 0) {
+        problems += "batch run failed\n";
+    }
+    if (records != expected) {
+        problems += "--- expected\n" + expected + "+++ records\n" + records;
+    }
+    if (secondRun.str() != firstRun.str()) {
+        problems += "second replay differs:\n" + secondRun.str();
+    }
+    return problems;
+}
+
+// String literals are interned once for every interpreter, so the line that
+// holds one is charged for it, and deleting the line gives the bytes back
+static std::string checkInternedLiteralsCharged() {
+    std::ostringstream output;
+    std::istringstream noInput;
+    AltairBasicInterpreter interpreter;
+    interpreter.setStreams(noInput, output);
+
+    std::string literal(1000, 'X');
+    size_t empty = interpreter.memoryUsed();
+    interpreter.processLine("10 A$ = \"" + literal + "\"");
+    size_t withLine = interpreter.memoryUsed();
+    interpreter.processLine("10");
+    size_t deleted = interpreter.memoryUsed();
+
+    std::string problems;
+    // The line keeps the literal's source text and its interned copy
+    if (withLine - empty < 2 * literal.size()) {
+        problems += "line with a " + std::to_string(literal.size()) + " character literal charged " +
+                    std::to_string(withLine - empty) + " bytes\n";
+    }
+    if (deleted != empty) {
+        problems += "deleting the line left " + std::to_string(deleted - empty) + " bytes charged\n";
+    }
+    return problems;
+}
+
+static const struct {
+    const char* name;
+    std::string (*check)();
+} sessionChecks[] = {
+    {"spill and rehydrate", checkSpillAndRehydrate},
+    {"lost spill file", checkLostSpillFile},
+    {"batch replay", checkBatchReplay},
+    {"interned literals charged", checkInternedLiteralsCharged},
+};
+
+static void runTest(TestCase& test) {
+    if (test.check) {
+        try {
+            test.diff = test.check();
+        } catch (const std::exception& e) {
+            test.diff = std::string(e.what()) + "\n";
+        }
+        test.passed = test.diff.empty();
+        return;
+    }
+
+    std::string program, expected;
+    if (!readFile(test.casePath, program)) {
+        test.passed = false;
+        test.diff = "cannot read " + test.casePath + "\n";
+        return;
+    }
+    if (!readFile(test.expectedPath, expected)) {
+        test.passed = false;
+        test.diff = "cannot read " + test.expectedPath + "\n";
+        return;
+    }
+
+    bool singlePrecision = test.name.size() > 11 && test.name.compare(test.name.size() - 11, 11, "_single.bas") == 0;
+    std::string actual = runSession(program, singlePrecision);
+    auto expectedLines = normalizedLines(expected);
+    auto actualLines = normalizedLines(actual);
+    test.passed = expectedLines == actualLines;
+    if (test.passed) {
+        return;
+    }
+
+    std::ostringstream diff;
+    diff << "--- " << test.expectedPath << "\n+++ actual\n";
+    size_t count = std::max(expectedLines.size(), actualLines.size());
+    for (size_t i = 0; i < count; i++) {
+        bool haveExpected = i < expectedLines.size();
+        bool haveActual = i < actualLines.size();
+        if (haveExpected && haveActual && expectedLines[i] == actualLines[i]) {
+            diff << " " << expectedLines[i] << "\n";
+            continue;
+        }
+        if (haveExpected) diff << "-" << expectedLines[i] << "\n";
+        if (haveActual) diff << "+" << actualLines[i] << "\n";
+    }
+    test.diff = diff.str();
+}
+
+int main(int argc, char* argv[]) {
+    std::string testsDir = "tests";
+    if (argc > 1) {
+        testsDir = argv[1];
+    } else if (const char* env = std::getenv("TESTS_SRCDIR")) {
+        testsDir = env;
+    }
+
+    std::string casesDir = testsDir + "/cases";
+    std::string expectedDir = testsDir + "/expected";
+
+    DIR* dir = opendir(casesDir.c_str());
+    if (!dir) {
+        std::cout << RED "❌ TEST CASES NOT FOUND at " << casesDir << NC << std::endl;
+        return 1;
+    }
+    std::vector<TestCase> tests;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bas") == 0) {
+            tests.push_back({name, casesDir + "/" + name, expectedDir + "/" + name + ".expected", false, "", nullptr});
+        }
+    }
+    closedir(dir);
+    std::sort(tests.begin(), tests.end(), [](const TestCase& a, const TestCase& b) { return a.name < b.name; });
+    for (const auto& check : sessionChecks) {
+        tests.push_back({check.name, "", "", false, "", check.check});
+    }
+
+    unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min<unsigned>(workers, tests.size() > 0 ? tests.size() : 1);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < workers; i++) {
+        pool.emplace_back([&]() {
+            for (size_t t = next++; t < tests.size(); t = next++) {
+                runTest(tests[t]);
+            }
+        });
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    int passedTests = 0;
+    int failedTests = 0;
+    for (const auto& test : tests) {
+        if (test.passed) {
+            std::cout << GREEN "✅ PASS:" NC " " << test.name << std::endl;
+            passedTests++;
+        } else {
+            std::cout << RED "❌ FAIL:" NC " " << test.name << std::endl;
+            failedTests++;
+            std::cout << "--------------------------------------------------" << std::endl;
+            std::cout << "Diff for " << test.name << ":" << std::endl;
+            std::cout << test.diff;
+            std::cout << "--------------------------------------------------" << std::endl;
+        }
+    }
+
+    std::cout << std::endl;
+    std::cout << "======================" << std::endl;
+    std::cout << "    TEST SUMMARY" << std::endl;
+    std::cout << "======================" << std::endl;
+    std::cout << "Total tests: " << tests.size() << std::endl;
+    std::cout << GREEN "Passed: " << passedTests << NC << std::endl;
+    std::cout << RED "Failed: " << failedTests << NC << std::endl;
+    std::cout << "======================" << std::endl;
+    std::cout << std::endl;
+
+    return failedTests == 0 ? 0 : 1;
+}